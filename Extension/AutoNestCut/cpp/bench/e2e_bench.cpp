@@ -0,0 +1,558 @@
+// End-to-end benchmark: runs the nester executable (read, parse, nest,
+// write) over a corpus of generated jobs and checked-in request files, and
+// puts speed and yield side by side.
+//
+// Usage: nester_bench_e2e [options] [request.json ...]
+//   --nester PATH         nester executable to measure (default: next to this tool)
+//   --compare PATH        second executable, reported as column B
+//   --a KEY=VALUE         override a setting for column A (kerf,
+//   --b KEY=VALUE         allow_rotation, min_offcut_size); --b alone
+//                         compares two settings on the same executable
+//   --kinds LIST          generated workload kinds (default: all, "none" for none)
+//   --sizes LIST          generated part counts (default: 1000,10000)
+//   --materials M         materials per generated job (default 3)
+//   --seed S              generator seed (default 1)
+//   --repeat R            runs per job; the fastest is reported (default 3)
+//   --format table|csv
+//   --work-dir DIR        where requests and responses are written
+//   --instances FMT:PATH  published benchmark instances (see instances.h;
+//                         FMT is 2bp or cut)
+//   --known-best FILE     best known sheet counts for those instances
+//
+// Without request files or instances the checked-in examples are included.
+
+#include "input_source.h"
+#include "instances.h"
+#include "json_reader.h"
+#include "request.h"
+#include "workload.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace AutoNestCut;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct SettingOverride {
+    std::string key;
+    double value;
+};
+
+// One column of the comparison: an executable plus setting overrides
+struct Variant {
+    std::string nester;
+    std::vector<SettingOverride> overrides;
+};
+
+struct Instance {
+    std::string name;
+    NestRequest request;
+    size_t lower_bound = 0; // Area bound on sheets, summed over materials
+    size_t known_best = 0;  // Best known sheet count, 0 if not known
+};
+
+struct RunResult {
+    bool ok = false;
+    double wall_ms = 0;
+    double nest_ms = 0;        // time_ms reported by the nester itself
+    double peak_rss_mb = 0;    // 0 where the platform does not report it
+    size_t sheets = 0;
+    size_t placed = 0;
+    double waste_percent = 0;
+    double free_rects_peak = 0;
+};
+
+// Picks the numbers the report needs out of a nester JSON response
+class ResponseHandler : public JsonHandler {
+public:
+    explicit ResponseHandler(RunResult& result) : result_(result) {}
+
+    bool start_object() override {
+        depth_++;
+        if (section_ == Section::PLACEMENTS && depth_ == 3) result_.placed++;
+        if (section_ == Section::BOARDS && depth_ == 3) {
+            result_.sheets++;
+            board_width_ = board_height_ = 0;
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        if (section_ == Section::BOARDS && depth_ == 3) board_area_ += board_width_ * board_height_;
+        depth_--;
+        if (depth_ == 1) section_ = Section::OTHER;
+        return true;
+    }
+
+    bool start_array() override {
+        depth_++;
+        return true;
+    }
+
+    bool end_array() override {
+        depth_--;
+        if (depth_ == 1) section_ = Section::OTHER;
+        return true;
+    }
+
+    bool key(std::string_view key) override {
+        if (depth_ == 1) {
+            section_ = key == "placements" ? Section::PLACEMENTS :
+                       key == "boards" ? Section::BOARDS :
+                       key == "stats" ? Section::STATS : Section::OTHER;
+        }
+        key_ = key;
+        return true;
+    }
+
+    bool number(double value) override {
+        if (section_ == Section::BOARDS && depth_ == 3) {
+            if (key_ == "width") board_width_ = value;
+            if (key_ == "height") board_height_ = value;
+            if (key_ == "used_area") used_area_ += value;
+        } else if (section_ == Section::STATS && depth_ == 2) {
+            if (key_ == "time_ms") result_.nest_ms = value;
+            if (key_ == "free_rects_peak") result_.free_rects_peak = value;
+        }
+        return true;
+    }
+
+    bool string(std::string_view) override { return true; }
+    bool boolean(bool) override { return true; }
+    bool null() override { return true; }
+
+    double waste_percent() const {
+        return board_area_ > 0 ? 100.0 * (1.0 - used_area_ / board_area_) : 0;
+    }
+
+private:
+    enum class Section { OTHER, PLACEMENTS, BOARDS, STATS };
+
+    RunResult& result_;
+    Section section_ = Section::OTHER;
+    int depth_ = 0;
+    std::string key_;
+    double board_width_ = 0;
+    double board_height_ = 0;
+    double board_area_ = 0;
+    double used_area_ = 0;
+};
+
+size_t area_lower_bound(const NestRequest& request) {
+    size_t bound = 0;
+    for (size_t m = 0; m < request.parts_by_material.size(); m++) {
+        const PartStore& parts = request.parts_by_material[m];
+        double area = 0;
+        for (uint32_t i = 0; i < parts.size(); i++) area += parts.area(i);
+        double board_area = request.board_sizes[m].width * request.board_sizes[m].height;
+        if (board_area > 0) bound += static_cast<size_t>(std::ceil(area / board_area - 1e-9));
+    }
+    return bound;
+}
+
+bool apply_override(Settings& settings, const SettingOverride& o) {
+    if (o.key == "kerf") settings.kerf_width = o.value;
+    else if (o.key == "allow_rotation") settings.allow_rotation = o.value != 0;
+    else if (o.key == "min_offcut_size") settings.min_offcut_size = o.value;
+    else return false;
+    return true;
+}
+
+bool parse_override(const char* text, std::vector<SettingOverride>& overrides) {
+    const char* eq = std::strchr(text, '=');
+    if (!eq) return false;
+    SettingOverride o{std::string(text, eq), 0};
+    std::string value = eq + 1;
+    o.value = value == "true" ? 1 : value == "false" ? 0 : std::atof(value.c_str());
+    Settings probe;
+    if (!apply_override(probe, o)) return false;
+    overrides.push_back(o);
+    return true;
+}
+
+std::vector<std::string> split_list(const std::string& text) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        if (comma > start) items.push_back(text.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+// Run `nester input output` with its console output discarded. Returns
+// false if it could not be started or failed.
+bool run_nester(const std::string& nester, const std::string& input, const std::string& output,
+                double& wall_ms, double& peak_rss_mb) {
+    auto start = std::chrono::steady_clock::now();
+    peak_rss_mb = 0;
+#ifdef _WIN32
+    std::string command = "\"\"" + nester + "\" \"" + input + "\" \"" + output + "\" >NUL 2>&1\"";
+    int status = std::system(command.c_str());
+    wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return status == 0;
+#else
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+        }
+        execl(nester.c_str(), nester.c_str(), input.c_str(), output.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    int status = 0;
+    struct rusage usage {};
+    if (wait4(pid, &status, 0, &usage) < 0) return false;
+    wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+#ifdef __APPLE__
+    peak_rss_mb = usage.ru_maxrss / (1024.0 * 1024.0); // Bytes on macOS
+#else
+    peak_rss_mb = usage.ru_maxrss / 1024.0; // KiB on Linux
+#endif
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+RunResult run_variant(Instance& instance, const Variant& variant, const std::string& tag,
+                      const fs::path& work_dir, int repeat) {
+    RunResult result;
+    Settings original = instance.request.settings;
+    for (const auto& o : variant.overrides) apply_override(instance.request.settings, o);
+    std::string input = (work_dir / (instance.name + "." + tag + ".in.json")).string();
+    std::string output = (work_dir / (instance.name + "." + tag + ".out.json")).string();
+    std::string error;
+    bool written = write_request(input, instance.request, error);
+    instance.request.settings = original;
+    if (!written) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return result;
+    }
+
+    double best_wall = INFINITY;
+    for (int r = 0; r < repeat; r++) {
+        double wall_ms, rss_mb;
+        if (!run_nester(variant.nester, input, output, wall_ms, rss_mb)) {
+            std::fprintf(stderr, "%s failed on %s\n", variant.nester.c_str(), instance.name.c_str());
+            return result;
+        }
+        best_wall = std::min(best_wall, wall_ms);
+        result.peak_rss_mb = std::max(result.peak_rss_mb, rss_mb);
+    }
+    result.wall_ms = best_wall;
+
+    MappedFile response;
+    if (!response.open(output, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return result;
+    }
+    JsonReader reader(response.data(), response.size());
+    ResponseHandler handler(result);
+    if (!parse_events(reader, handler)) {
+        std::fprintf(stderr, "Unreadable response for %s\n", instance.name.c_str());
+        return result;
+    }
+    result.waste_percent = handler.waste_percent();
+    result.ok = true;
+    return result;
+}
+
+double gap_percent(const RunResult& r, size_t lower_bound) {
+    return lower_bound > 0 ? 100.0 * (static_cast<double>(r.sheets) - lower_bound) / lower_bound : 0;
+}
+
+void print_table(const std::vector<Instance>& instances, const std::vector<std::vector<RunResult>>& results,
+                 size_t variants) {
+    bool with_best = std::any_of(instances.begin(), instances.end(),
+        [](const Instance& instance) { return instance.known_best > 0; });
+
+    std::printf("%-24s %7s %5s", "instance", "parts", "LB");
+    if (with_best) std::printf(" %5s", "best");
+    for (size_t v = 0; v < variants; v++) {
+        char c = static_cast<char>('A' + v);
+        std::printf(" | %c:sheets %7s", c, "gap%");
+        if (with_best) std::printf(" %5s", "+best");
+        std::printf(" %7s %9s %8s %8s %6s", "waste%", "wall_ms", "nest_ms", "rss_mb", "frects");
+    }
+    if (variants == 2) std::printf(" | %7s %7s", "dwall%", "dsheets");
+    std::printf("\n");
+
+    double total_wall[2] = {0, 0};
+    size_t total_sheets[2] = {0, 0};
+    for (size_t i = 0; i < instances.size(); i++) {
+        const Instance& instance = instances[i];
+        std::printf("%-24s %7zu %5zu", instance.name.c_str(), instance.request.part_count, instance.lower_bound);
+        if (with_best) {
+            if (instance.known_best > 0) std::printf(" %5zu", instance.known_best);
+            else std::printf(" %5s", "-");
+        }
+        for (size_t v = 0; v < variants; v++) {
+            const RunResult& r = results[i][v];
+            if (!r.ok) {
+                std::printf(" | %8s %7s", "failed", "");
+                if (with_best) std::printf(" %5s", "");
+                std::printf(" %7s %9s %8s %8s %6s", "", "", "", "", "");
+                continue;
+            }
+            std::printf(" | %8zu %7.2f", r.sheets, gap_percent(r, instance.lower_bound));
+            if (with_best) {
+                if (instance.known_best > 0) {
+                    std::printf(" %+5lld", static_cast<long long>(r.sheets) - static_cast<long long>(instance.known_best));
+                } else {
+                    std::printf(" %5s", "-");
+                }
+            }
+            std::printf(" %7.2f %9.1f %8.0f %8.1f %6.0f",
+                        r.waste_percent, r.wall_ms, r.nest_ms, r.peak_rss_mb, r.free_rects_peak);
+            total_wall[v] += r.wall_ms;
+            total_sheets[v] += r.sheets;
+        }
+        if (variants == 2 && results[i][0].ok && results[i][1].ok) {
+            const RunResult& a = results[i][0];
+            const RunResult& b = results[i][1];
+            std::printf(" | %+7.1f %+7lld", 100.0 * (b.wall_ms - a.wall_ms) / a.wall_ms,
+                        static_cast<long long>(b.sheets) - static_cast<long long>(a.sheets));
+        }
+        std::printf("\n");
+    }
+
+    std::printf("%-24s %7s %5s", "total", "", "");
+    if (with_best) std::printf(" %5s", "");
+    for (size_t v = 0; v < variants; v++) {
+        std::printf(" | %8zu %7s", total_sheets[v], "");
+        if (with_best) std::printf(" %5s", "");
+        std::printf(" %7s %9.1f %8s %8s %6s", "", total_wall[v], "", "", "");
+    }
+    if (variants == 2 && total_wall[0] > 0) {
+        std::printf(" | %+7.1f %+7lld", 100.0 * (total_wall[1] - total_wall[0]) / total_wall[0],
+                    static_cast<long long>(total_sheets[1]) - static_cast<long long>(total_sheets[0]));
+    }
+    std::printf("\n");
+}
+
+void print_csv(const std::vector<Instance>& instances, const std::vector<std::vector<RunResult>>& results,
+               size_t variants) {
+    std::printf("instance,variant,parts,lower_bound,known_best,ok,placed,sheets,gap_percent,waste_percent,"
+                "wall_ms,nest_ms,peak_rss_mb,free_rects_peak\n");
+    for (size_t i = 0; i < instances.size(); i++) {
+        const Instance& instance = instances[i];
+        for (size_t v = 0; v < variants; v++) {
+            const RunResult& r = results[i][v];
+            std::printf("%s,%c,%zu,%zu,%zu,%d,%zu,%zu,%.3f,%.3f,%.2f,%.0f,%.2f,%.0f\n",
+                        instance.name.c_str(), static_cast<char>('A' + v), instance.request.part_count,
+                        instance.lower_bound, instance.known_best, r.ok ? 1 : 0, r.placed, r.sheets,
+                        gap_percent(r, instance.lower_bound), r.waste_percent, r.wall_ms, r.nest_ms,
+                        r.peak_rss_mb, r.free_rects_peak);
+        }
+    }
+}
+
+void print_usage() {
+    std::fprintf(stderr,
+        "Usage: nester_bench_e2e [--nester PATH] [--compare PATH] [--a KEY=VALUE] [--b KEY=VALUE]\n"
+        "                        [--kinds LIST] [--sizes LIST] [--materials M] [--seed S]\n"
+        "                        [--repeat R] [--format table|csv] [--work-dir DIR]\n"
+        "                        [--instances 2bp|cut:PATH] [--known-best FILE] [request.json ...]\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    fs::path tool_dir = fs::path(argv[0]).parent_path();
+#ifdef _WIN32
+    Variant a{(tool_dir / "nester.exe").string(), {}};
+#else
+    Variant a{(tool_dir / "nester").string(), {}};
+#endif
+    Variant b;
+    bool compare = false;
+    std::vector<std::string> kinds = {"kitchen", "wardrobe", "shelving", "uniform", "heavy-tailed"};
+    std::vector<std::string> sizes = {"1000", "10000"};
+    WorkloadSpec base_spec;
+    int repeat = 3;
+    std::string format = "table";
+    fs::path work_dir = fs::temp_directory_path() / "nester_bench_e2e";
+    std::vector<std::string> files;
+    std::vector<std::pair<InstanceFormat, std::string>> instance_files;
+    std::string known_best_file;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--nester" && has_value) {
+            a.nester = argv[++i];
+        } else if (arg == "--compare" && has_value) {
+            b.nester = argv[++i];
+            compare = true;
+        } else if (arg == "--a" && has_value) {
+            if (!parse_override(argv[++i], a.overrides)) {
+                std::fprintf(stderr, "Unknown setting: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--b" && has_value) {
+            if (!parse_override(argv[++i], b.overrides)) {
+                std::fprintf(stderr, "Unknown setting: %s\n", argv[i]);
+                return 1;
+            }
+            compare = true;
+        } else if (arg == "--kinds" && has_value) {
+            kinds = split_list(argv[++i]);
+            if (kinds.size() == 1 && kinds[0] == "none") kinds.clear();
+        } else if (arg == "--sizes" && has_value) {
+            sizes = split_list(argv[++i]);
+        } else if (arg == "--materials" && has_value) {
+            base_spec.materials = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && has_value) {
+            base_spec.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--repeat" && has_value) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--format" && has_value) {
+            format = argv[++i];
+        } else if (arg == "--work-dir" && has_value) {
+            work_dir = argv[++i];
+        } else if (arg == "--instances" && has_value) {
+            std::string spec = argv[++i];
+            size_t colon = spec.find(':');
+            InstanceFormat instance_format;
+            if (colon == std::string::npos ||
+                !parse_instance_format(std::string_view(spec).substr(0, colon), instance_format)) {
+                std::fprintf(stderr, "Expected --instances 2bp:PATH or cut:PATH\n");
+                return 1;
+            }
+            instance_files.emplace_back(instance_format, spec.substr(colon + 1));
+        } else if (arg == "--known-best" && has_value) {
+            known_best_file = argv[++i];
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            print_usage();
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (b.nester.empty()) b.nester = a.nester;
+    if (format != "table" && format != "csv") {
+        print_usage();
+        return 1;
+    }
+#ifdef AUTONESTCUT_SOURCE_DIR
+    if (files.empty() && instance_files.empty()) {
+        files = {AUTONESTCUT_SOURCE_DIR "/quick_test_input.json", AUTONESTCUT_SOURCE_DIR "/test_input.json"};
+    }
+#endif
+
+    std::error_code ec;
+    fs::create_directories(work_dir, ec);
+    if (ec) {
+        std::fprintf(stderr, "Cannot create work directory: %s\n", work_dir.string().c_str());
+        return 1;
+    }
+
+    // Build the corpus: generated jobs first, then request files
+    std::vector<std::pair<std::string, std::string>> corpus; // Name and path
+    for (const auto& kind_name : kinds) {
+        WorkloadSpec spec = base_spec;
+        if (!parse_workload_kind(kind_name, spec.kind)) {
+            std::fprintf(stderr, "Unknown workload kind: %s\n", kind_name.c_str());
+            return 1;
+        }
+        for (const auto& size : sizes) {
+            spec.parts = std::strtoul(size.c_str(), nullptr, 10);
+            std::string name = kind_name + "-" + size;
+            std::string path = (work_dir / (name + ".json")).string();
+            std::FILE* file = std::fopen(path.c_str(), "wb");
+            bool written = file && write_workload(file, generate_workload(spec));
+            if (file && std::fclose(file) != 0) written = false;
+            if (!written) {
+                std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+                return 1;
+            }
+            corpus.emplace_back(name, path);
+        }
+    }
+    for (const auto& file : files) corpus.emplace_back(fs::path(file).stem().string(), file);
+
+    std::vector<Instance> instances;
+    for (const auto& [name, path] : corpus) {
+        Instance instance;
+        instance.name = name;
+        MappedFile input;
+        std::string error;
+        if (!input.open(path, error) ||
+            !parse_request(input.data(), input.size(), instance.request, error)) {
+            std::fprintf(stderr, "Skipping %s: %s\n", path.c_str(), error.c_str());
+            continue;
+        }
+        instance.lower_bound = area_lower_bound(instance.request);
+        instances.push_back(std::move(instance));
+    }
+
+    // Published instances, loaded straight into requests
+    std::unordered_map<std::string, size_t> known_best;
+    if (!known_best_file.empty()) {
+        std::string error;
+        if (!load_known_best(known_best_file, known_best, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    for (const auto& [instance_format, path] : instance_files) {
+        std::vector<BenchmarkInstance> loaded;
+        std::string error;
+        if (!load_instances(path, instance_format, loaded, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        for (auto& benchmark : loaded) {
+            Instance instance;
+            instance.name = std::move(benchmark.name);
+            instance.request = std::move(benchmark.request);
+            instance.lower_bound = area_lower_bound(instance.request);
+            auto best = known_best.find(instance.name);
+            if (best != known_best.end()) instance.known_best = best->second;
+            instances.push_back(std::move(instance));
+        }
+    }
+
+    size_t variants = compare ? 2 : 1;
+    std::vector<std::vector<RunResult>> results;
+    for (auto& instance : instances) {
+        std::fprintf(stderr, "Running %s (%zu parts)\n", instance.name.c_str(), instance.request.part_count);
+        std::vector<RunResult> row;
+        row.push_back(run_variant(instance, a, "A", work_dir, repeat));
+        if (compare) row.push_back(run_variant(instance, b, "B", work_dir, repeat));
+        results.push_back(row);
+    }
+
+    if (format == "csv") {
+        print_csv(instances, results, variants);
+    } else {
+        print_table(instances, results, variants);
+    }
+
+    for (const auto& row : results) {
+        for (const auto& r : row) {
+            if (!r.ok) return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include "instances.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace AutoNestCut {
+
+namespace {
+
+// Leading numbers of a line, up to the first token that is not a number
+std::vector<double> leading_numbers(const std::string& line) {
+    std::vector<double> numbers;
+    std::istringstream tokens(line);
+    std::string token;
+    while (tokens >> token) {
+        char* end = nullptr;
+        double value = std::strtod(token.c_str(), &end);
+        if (end == token.c_str() || *end != '\0') break;
+        numbers.push_back(value);
+    }
+    return numbers;
+}
+
+// Lines of the file that start with at least one number
+bool numeric_lines(const std::string& path, std::vector<std::vector<double>>& lines, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "Cannot open instance file: " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<double> numbers = leading_numbers(line);
+        if (!numbers.empty()) lines.push_back(std::move(numbers));
+    }
+    return true;
+}
+
+BenchmarkInstance make_instance(std::string name, double bin_width, double bin_height) {
+    BenchmarkInstance instance;
+    instance.name = std::move(name);
+    NestRequest& request = instance.request;
+    request.settings.kerf_width = 0;
+    request.settings.allow_rotation = false;
+    MaterialId material = request.material_id("bin");
+    request.board_sizes[material] = {bin_width, bin_height};
+    return instance;
+}
+
+void add_item(BenchmarkInstance& instance, double width, double height, uint32_t type, uint32_t copy) {
+    NestRequest& request = instance.request;
+    Part part;
+    part.width = width;
+    part.height = height;
+    part.id = request.part_ids.add("item_" + std::to_string(type + 1) +
+                                   (copy > 0 ? "_" + std::to_string(copy + 1) : ""));
+    part.material = 0;
+    part.grain = request.grain_id("any");
+    part.type_index = type;
+    part.instance = copy;
+    request.parts_by_material[0].add(part);
+    request.part_count++;
+}
+
+bool load_2bp(const std::string& path, std::vector<BenchmarkInstance>& instances, std::string& error) {
+    std::vector<std::vector<double>> lines;
+    if (!numeric_lines(path, lines, error)) return false;
+
+    size_t loaded = 0;
+    size_t at = 0;
+    while (at < lines.size()) {
+        // Header: class, item count, instance numbers, bin size
+        if (at + 4 > lines.size() || lines[at + 2].size() < 2 || lines[at + 3].size() < 2) {
+            error = "Truncated instance header in " + path;
+            return false;
+        }
+        int problem_class = static_cast<int>(lines[at][0]);
+        size_t items = static_cast<size_t>(lines[at + 1][0]);
+        int relative = static_cast<int>(lines[at + 2][0]);
+        double bin_height = lines[at + 3][0];
+        double bin_width = lines[at + 3][1];
+        at += 4;
+        if (at + items > lines.size()) {
+            error = "Truncated item list in " + path;
+            return false;
+        }
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "c%02d_n%03zu_%02d", problem_class, items, relative);
+        BenchmarkInstance instance = make_instance(name, bin_width, bin_height);
+        for (size_t i = 0; i < items; i++, at++) {
+            const std::vector<double>& item = lines[at];
+            if (item.size() < 2) {
+                error = "Item without height and width in " + path;
+                return false;
+            }
+            add_item(instance, item[1], item[0], static_cast<uint32_t>(i), 0);
+        }
+        assign_rotations(instance.request);
+        instances.push_back(std::move(instance));
+        loaded++;
+    }
+
+    if (loaded == 0) {
+        error = "No instances in " + path;
+        return false;
+    }
+    return true;
+}
+
+bool load_cut(const std::string& path, std::vector<BenchmarkInstance>& instances, std::string& error) {
+    std::vector<std::vector<double>> lines;
+    if (!numeric_lines(path, lines, error)) return false;
+    if (lines.size() < 2 || lines[1].size() < 2) {
+        error = "Missing piece count or stock size in " + path;
+        return false;
+    }
+
+    size_t types = static_cast<size_t>(lines[0][0]);
+    if (lines.size() < 2 + types) {
+        error = "Truncated piece list in " + path;
+        return false;
+    }
+
+    BenchmarkInstance instance = make_instance(std::filesystem::path(path).stem().string(),
+                                               lines[1][0], lines[1][1]);
+    for (size_t t = 0; t < types; t++) {
+        const std::vector<double>& piece = lines[2 + t];
+        if (piece.size() < 2) {
+            error = "Piece without width and height in " + path;
+            return false;
+        }
+        size_t demand = piece.size() >= 3 ? static_cast<size_t>(piece[2]) : 1;
+        for (size_t copy = 0; copy < demand; copy++) {
+            add_item(instance, piece[0], piece[1], static_cast<uint32_t>(t), static_cast<uint32_t>(copy));
+        }
+    }
+    assign_rotations(instance.request);
+    instances.push_back(std::move(instance));
+    return true;
+}
+
+} // namespace
+
+bool parse_instance_format(std::string_view name, InstanceFormat& format) {
+    if (name == "2bp") {
+        format = InstanceFormat::BIN_PACKING_2BP;
+    } else if (name == "cut") {
+        format = InstanceFormat::CUTTING;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool load_instances(const std::string& path, InstanceFormat format,
+                    std::vector<BenchmarkInstance>& instances, std::string& error) {
+    switch (format) {
+        case InstanceFormat::BIN_PACKING_2BP: return load_2bp(path, instances, error);
+        case InstanceFormat::CUTTING: return load_cut(path, instances, error);
+    }
+    return false;
+}
+
+bool load_known_best(const std::string& path, std::unordered_map<std::string, size_t>& best,
+                     std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "Cannot open known-best file: " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string name;
+        size_t sheets;
+        if (fields >> name >> sheets) best[name] = sheets;
+    }
+    return true;
+}
+
+} // namespace AutoNestCut
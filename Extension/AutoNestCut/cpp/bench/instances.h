@@ -0,0 +1,50 @@
+#pragma once
+
+#include "request.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Loaders for published 2D bin-packing benchmark instances, converted into
+// nesting jobs: one material whose board is the bin, one part per item copy,
+// no kerf and no rotation (the oriented variant of the problems; override
+// allow_rotation to compare against rotated results).
+//
+//   2bp  The 2BP library layout used for the Berkey-Wang classes 1-6 and
+//        the Martello-Vigo classes 7-10. A file holds several instances,
+//        each a block of: problem class; number of items; relative and
+//        absolute instance number; bin height and width; then one line per
+//        item with its height and width. Text after the numbers on a line
+//        and lines without numbers are ignored. Instances are named
+//        "c<class>_n<items>_<relative number>", e.g. "c01_n020_01".
+//
+//   cut  Two-dimensional cutting instances listing piece types: the number
+//        of types; stock width and height; then one line per type with its
+//        width, height and optionally its demand (copies, default 1).
+//        Named after the file.
+enum class InstanceFormat {
+    BIN_PACKING_2BP,
+    CUTTING,
+};
+
+struct BenchmarkInstance {
+    std::string name;
+    NestRequest request;
+};
+
+bool parse_instance_format(std::string_view name, InstanceFormat& format);
+
+bool load_instances(const std::string& path, InstanceFormat format,
+                    std::vector<BenchmarkInstance>& instances, std::string& error);
+
+// Best known sheet counts, one "<instance name> <sheets>" pair per line;
+// '#' starts a comment. No values are shipped: take them from the
+// literature for the instances being run.
+bool load_known_best(const std::string& path, std::unordered_map<std::string, size_t>& best,
+                     std::string& error);
+
+} // namespace AutoNestCut
@@ -0,0 +1,386 @@
+// Microbenchmarks for the solver's hot primitives: rectangle tests, free-rect
+// search and update on boards with free lists of several sizes, the request
+// parser and the output writer.
+//
+// Each benchmark is calibrated to run for at least --min-time seconds per
+// repetition and reports the fastest and the median repetition in ns per
+// operation, which is much more stable between runs than the mean.
+//
+// Usage: nester_bench [--filter TEXT] [--format csv|json] [--min-time S]
+//                     [--repetitions R]
+
+#include "geometry.h"
+#include "json_writer.h"
+#include "nesting.h"
+#include "request.h"
+#include "solution.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace AutoNestCut;
+
+namespace {
+
+// Results are folded into this so the compiler cannot drop the work
+volatile double benchmark_sink = 0;
+
+// One registered benchmark. `run` performs `iterations` operations and may
+// do untimed setup first by calling `start` once it is ready.
+struct Benchmark {
+    std::string name;
+    size_t size;
+    std::function<void(size_t iterations, std::function<void()>& start)> run;
+};
+
+struct Result {
+    std::string name;
+    size_t size;
+    size_t iterations;
+    int repetitions;
+    double min_ns;
+    double median_ns;
+};
+
+double elapsed_ns(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Time `iterations` operations, excluding setup done before start()
+double time_run(const Benchmark& benchmark, size_t iterations) {
+    std::chrono::steady_clock::time_point begin;
+    std::function<void()> start = [&begin]() { begin = std::chrono::steady_clock::now(); };
+    begin = std::chrono::steady_clock::now();
+    benchmark.run(iterations, start);
+    return elapsed_ns(begin);
+}
+
+Result measure(const Benchmark& benchmark, double min_time_s, int repetitions) {
+    // Grow the iteration count until one run takes long enough
+    size_t iterations = 1;
+    double min_ns = min_time_s * 1e9;
+    for (;;) {
+        double ns = time_run(benchmark, iterations);
+        if (ns >= min_ns || iterations >= (size_t(1) << 30)) break;
+        double scale = ns > 0 ? 1.4 * min_ns / ns : 10.0;
+        iterations = static_cast<size_t>(iterations * std::clamp(scale, 2.0, 10.0));
+    }
+
+    std::vector<double> per_op;
+    for (int r = 0; r < repetitions; r++) {
+        per_op.push_back(time_run(benchmark, iterations) / static_cast<double>(iterations));
+    }
+    std::sort(per_op.begin(), per_op.end());
+    return {benchmark.name, benchmark.size, iterations, repetitions, per_op.front(), per_op[per_op.size() / 2]};
+}
+
+std::vector<Rect> random_rects(size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<double> pos(0, 2000);
+    std::uniform_real_distribution<double> len(10, 600);
+    std::vector<Rect> rects;
+    for (size_t i = 0; i < count; i++) rects.emplace_back(pos(rng), pos(rng), len(rng), len(rng));
+    return rects;
+}
+
+// A board whose free list has grown to about `target` rectangles, built the
+// way nest_parts builds it: small parts placed bottom-left until the list is
+// that long. The placed parts are added to `parts` and `placements`.
+Board grown_board(size_t target, PartStore& parts, std::vector<Placement>& placements) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> len(20, 200);
+    Board board(1, 0, 20000, 20000);
+    while (board.free_rectangles.size() < target) {
+        Part part;
+        part.width = len(rng);
+        part.height = len(rng);
+        uint32_t index = parts.add(part);
+        double x, y;
+        if (!board.find_best_position(part.width, part.height, 3.0, x, y)) break;
+        board.add_part(parts, index, 0, x, y, 3.0, placements);
+    }
+    return board;
+}
+
+std::string generate_request(size_t count) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> len(50, 1200);
+    const char* grains[] = {"any", "vertical", "fixed"};
+    std::string json = "{\"settings\":{\"kerf\":3.0,\"allow_rotation\":true},"
+                       "\"boards\":[{\"material\":\"Plywood_18mm\",\"width\":2440,\"height\":1220}],"
+                       "\"parts\":[";
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) json += ',';
+        json += "{\"id\":\"part_" + std::to_string(i) + "\",\"name\":\"Side panel\","
+                "\"material\":\"Plywood_18mm\",\"width\":" + std::to_string(len(rng)) +
+                ",\"height\":" + std::to_string(len(rng)) +
+                ",\"thickness\":18,\"grain_direction\":\"" + grains[i % 3] + "\"}";
+    }
+    json += "]}";
+    return json;
+}
+
+// A layout with 20 parts per board; only its size matters to the writer
+Solution synthetic_solution(const PartStore& parts) {
+    Solution solution;
+    for (uint32_t i = 0; i < parts.size(); i++) {
+        if (i % 20 == 0) {
+            BoardRecord board{};
+            board.width = 2440;
+            board.height = 1220;
+            board.id = static_cast<int32_t>(solution.boards.size() + 1);
+            board.first_placement = i;
+            solution.boards.push_back(board);
+        }
+        BoardRecord& board = solution.boards.back();
+        Placement placement{};
+        placement.x = (i % 5) * 488.0;
+        placement.y = (i % 20 / 5) * 305.0;
+        placement.part = i;
+        placement.board_id = board.id;
+        placement.rotation = (i % 2) * 90;
+        solution.placements.push_back(placement);
+        board.placement_count++;
+        board.placed_area += parts.area(i);
+    }
+    return solution;
+}
+
+// Same document shape as the nester's JSON output
+void write_response(std::FILE* file, const Solution& solution, const NestRequest& request) {
+    JsonWriter json(file);
+    json.begin_object();
+    json.key("placements").begin_array();
+    for (const auto& placement : solution.placements) {
+        const PartStore& parts = request.parts_by_material[placement.material];
+        json.begin_object()
+            .member("part_id", request.part_ids.get(parts.id[placement.part]))
+            .member("board_id", placement.board_id)
+            .member("x", placement.x)
+            .member("y", placement.y)
+            .member("rotation", placement.rotation)
+            .end_object();
+    }
+    json.end_array();
+    json.key("boards").begin_array();
+    for (const auto& board : solution.boards) {
+        json.begin_object()
+            .member("id", board.id)
+            .member("material", request.materials.get(board.material))
+            .member("width", board.width)
+            .member("height", board.height)
+            .member("parts_count", board.placement_count)
+            .member("used_area", board.used_area())
+            .member("waste_percentage", board.waste_percentage())
+            .end_object();
+    }
+    json.end_array();
+    json.end_object();
+    json.flush();
+}
+
+std::vector<Benchmark> register_benchmarks() {
+    std::vector<Benchmark> benchmarks;
+
+    // Rectangle primitives, over a fixed pool of random pairs
+    benchmarks.push_back({"intersects", 1, [](size_t iterations, std::function<void()>& start) {
+        std::mt19937 rng(1);
+        std::vector<Rect> a = random_rects(1024, rng);
+        std::vector<Rect> b = random_rects(1024, rng);
+        start();
+        size_t hits = 0;
+        for (size_t i = 0; i < iterations; i++) hits += intersects(a[i & 1023], b[(i * 7) & 1023]);
+        benchmark_sink = benchmark_sink + hits;
+    }});
+
+    benchmarks.push_back({"subtract_rect", 1, [](size_t iterations, std::function<void()>& start) {
+        std::mt19937 rng(2);
+        std::vector<Rect> a = random_rects(1024, rng);
+        std::vector<Rect> b = random_rects(1024, rng);
+        start();
+        int pieces = 0;
+        Rect out[4];
+        for (size_t i = 0; i < iterations; i++) pieces += subtract_rect(a[i & 1023], b[(i * 7) & 1023], out);
+        benchmark_sink = benchmark_sink + pieces + out[0].x;
+    }});
+
+    for (size_t size : {16, 64, 256, 1024}) {
+        // A part that fits somewhere in the middle of the free list
+        benchmarks.push_back({"find_best_position_hit", size, [size](size_t iterations, std::function<void()>& start) {
+            PartStore parts;
+            std::vector<Placement> placements;
+            Board board = grown_board(size, parts, placements);
+            const Rect& middle = board.free_rectangles[board.free_rectangles.size() / 2];
+            double w = middle.width - 3.0;
+            double h = middle.height - 3.0;
+            start();
+            double sum = 0;
+            for (size_t i = 0; i < iterations; i++) {
+                double x = 0, y = 0;
+                board.find_best_position(w, h, 3.0, x, y);
+                sum += x + y;
+            }
+            benchmark_sink = benchmark_sink + sum;
+        }});
+
+        // A part that fits nowhere: a scan of the whole list
+        benchmarks.push_back({"find_best_position_miss", size, [size](size_t iterations, std::function<void()>& start) {
+            PartStore parts;
+            std::vector<Placement> placements;
+            Board board = grown_board(size, parts, placements);
+            start();
+            size_t found = 0;
+            for (size_t i = 0; i < iterations; i++) {
+                double x, y;
+                found += board.find_best_position(30000, 50, 3.0, x, y);
+            }
+            benchmark_sink = benchmark_sink + found;
+        }});
+
+        // Each operation restores the free list from a snapshot (no
+        // allocation, capacity is kept) and places one part; compare with
+        // board_restore for the cost of the restore alone
+        for (bool place : {true, false}) {
+            benchmarks.push_back({place ? "add_part" : "board_restore", size,
+                                  [size, place](size_t iterations, std::function<void()>& start) {
+                PartStore parts;
+                std::vector<Placement> placements;
+                Board board = grown_board(size, parts, placements);
+                std::vector<Rect> snapshot(board.free_rectangles.begin(), board.free_rectangles.end());
+                Part part;
+                part.width = 120;
+                part.height = 80;
+                uint32_t index = parts.add(part);
+                double x = 0, y = 0;
+                board.find_best_position(part.width, part.height, 3.0, x, y);
+                placements.reserve(placements.size() + 1);
+                board.scratch_rectangles.reserve(snapshot.size() * 2);
+                start();
+                for (size_t i = 0; i < iterations; i++) {
+                    board.free_rectangles.assign(snapshot.begin(), snapshot.end());
+                    if (place) {
+                        board.add_part(parts, index, 0, x, y, 3.0, placements);
+                        placements.pop_back();
+                    }
+                }
+                benchmark_sink = benchmark_sink + board.free_rectangles.size();
+            }});
+        }
+    }
+
+    for (size_t size : {1000, 10000, 100000}) {
+        // The parser decodes in place, so each operation parses a fresh copy;
+        // the copy is a small fraction of the time
+        benchmarks.push_back({"parse_request", size, [size](size_t iterations, std::function<void()>& start) {
+            std::string json = generate_request(size);
+            std::vector<char> buffer(json.size());
+            start();
+            for (size_t i = 0; i < iterations; i++) {
+                std::memcpy(buffer.data(), json.data(), json.size());
+                NestRequest request;
+                std::string error;
+                parse_request(buffer.data(), buffer.size(), request, error);
+                benchmark_sink = benchmark_sink + request.part_count;
+            }
+        }});
+
+        benchmarks.push_back({"write_response", size, [size](size_t iterations, std::function<void()>& start) {
+            std::string json = generate_request(size);
+            NestRequest request;
+            std::string error;
+            parse_request(json.data(), json.size(), request, error);
+            Solution solution = synthetic_solution(request.parts_by_material[0]);
+            std::FILE* file = std::tmpfile();
+            if (!file) return;
+            start();
+            for (size_t i = 0; i < iterations; i++) {
+                std::rewind(file);
+                write_response(file, solution, request);
+            }
+            benchmark_sink = benchmark_sink + std::ftell(file);
+            std::fclose(file);
+        }});
+    }
+
+    return benchmarks;
+}
+
+void print_csv(const std::vector<Result>& results) {
+    std::printf("benchmark,size,iterations,repetitions,min_ns,median_ns\n");
+    for (const auto& r : results) {
+        std::printf("%s,%zu,%zu,%d,%.2f,%.2f\n",
+                    r.name.c_str(), r.size, r.iterations, r.repetitions, r.min_ns, r.median_ns);
+    }
+}
+
+void print_json(const std::vector<Result>& results, double min_time_s) {
+    JsonWriter json(stdout);
+    json.begin_object();
+    json.key("context").begin_object()
+        .member("min_time_s", min_time_s)
+        .member("time_unit", "ns")
+        .end_object();
+    json.key("benchmarks").begin_array();
+    for (const auto& r : results) {
+        json.begin_object()
+            .member("name", r.name + "/" + std::to_string(r.size))
+            .member("size", r.size)
+            .member("iterations", r.iterations)
+            .member("repetitions", r.repetitions)
+            .member("min_ns", r.min_ns)
+            .member("median_ns", r.median_ns)
+            .end_object();
+    }
+    json.end_array();
+    json.end_object();
+    json.flush();
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string format = "csv";
+    double min_time_s = 0.2;
+    int repetitions = 5;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            format = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time_s = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: nester_bench [--filter TEXT] [--format csv|json] "
+                                 "[--min-time S] [--repetitions R]\n");
+            return 1;
+        }
+    }
+    if (format != "csv" && format != "json") {
+        std::fprintf(stderr, "Unknown format: %s\n", format.c_str());
+        return 1;
+    }
+
+    std::vector<Result> results;
+    for (const auto& benchmark : register_benchmarks()) {
+        std::string full_name = benchmark.name + "/" + std::to_string(benchmark.size);
+        if (!filter.empty() && full_name.find(filter) == std::string::npos) continue;
+        results.push_back(measure(benchmark, min_time_s, repetitions));
+    }
+
+    if (format == "json") {
+        print_json(results, min_time_s);
+    } else {
+        print_csv(results);
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Part layout benchmark: array-of-structs Part objects (the layout nest_parts
+// used to sort and place) versus the PartStore structure-of-arrays with index
+// permutations. Both sides run the same area sort and the same shelf-packing
+// sweep over the parts, so the difference is the memory layout.
+//
+// Usage: nester_bench_layout [--parts N] [--layout aos|soa|both] [--repeat R]
+//
+// For cache-miss counts, run one layout at a time under perf, e.g.
+//   perf stat -e cache-references,cache-misses nester_bench_layout --layout aos
+//   perf stat -e cache-references,cache-misses nester_bench_layout --layout soa
+
+#include "part_store.h"
+#include "solution.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace AutoNestCut;
+
+namespace {
+
+// Layout of Part before the structure-of-arrays split
+struct LegacyPart {
+    std::string id;
+    std::string material;
+    double width;
+    double height;
+    std::string grain_direction;
+    std::vector<int> allowed_rotations;
+    double x = 0;
+    double y = 0;
+    int rotation = 0;
+    int board_id = -1;
+
+    double area() const { return width * height; }
+};
+
+struct Shelf {
+    double board_width;
+    double board_height;
+    double cursor_x = 0;
+    double cursor_y = 0;
+    double shelf_height = 0;
+    int board = 1;
+
+    // Place a w x h rectangle on the current shelf, opening new shelves/boards as needed
+    void place(double w, double h, double& out_x, double& out_y, int& out_board) {
+        if (cursor_x + w > board_width) {
+            cursor_x = 0;
+            cursor_y += shelf_height;
+            shelf_height = 0;
+        }
+        if (cursor_y + h > board_height) {
+            board++;
+            cursor_x = 0;
+            cursor_y = 0;
+            shelf_height = 0;
+        }
+        out_x = cursor_x;
+        out_y = cursor_y;
+        out_board = board;
+        cursor_x += w;
+        shelf_height = std::max(shelf_height, h);
+    }
+};
+
+struct Timing {
+    double sort_ms = 0;
+    double sweep_ms = 0;
+    double checksum = 0;
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+Timing run_aos(const std::vector<Part>& input) {
+    std::vector<LegacyPart> parts;
+    parts.reserve(input.size());
+    for (const auto& p : input) {
+        LegacyPart part;
+        part.id = "cabinet_part_" + std::to_string(p.id);
+        part.material = "Plywood_18mm_Birch";
+        part.width = p.width;
+        part.height = p.height;
+        part.grain_direction = p.grain ? "vertical" : "any";
+        part.allowed_rotations = p.grain ? std::vector<int>{0} : std::vector<int>{0, 90};
+        parts.push_back(std::move(part));
+    }
+
+    Timing t;
+    auto start = std::chrono::steady_clock::now();
+    std::sort(parts.begin(), parts.end(),
+        [](const LegacyPart& a, const LegacyPart& b) { return a.area() > b.area(); });
+    t.sort_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    Shelf shelf{2440, 1220};
+    for (auto& part : parts) {
+        double w = part.width;
+        double h = part.height;
+        for (int rot : part.allowed_rotations) {
+            if (rot == 90 && part.height > part.width) std::swap(w, h);
+        }
+        shelf.place(w, h, part.x, part.y, part.board_id);
+    }
+    t.sweep_ms = elapsed_ms(start);
+
+    for (const auto& part : parts) t.checksum += part.x + part.y + part.board_id;
+    return t;
+}
+
+Timing run_soa(const std::vector<Part>& input) {
+    PartStore parts;
+    parts.reserve(input.size());
+    for (const auto& p : input) {
+        uint32_t i = parts.add(p);
+        parts.rotations[i] = p.grain ? ROTATE_0 : (ROTATE_0 | ROTATE_90);
+    }
+
+    Timing t;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> order(parts.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(),
+        [&parts](uint32_t a, uint32_t b) { return parts.area(a) > parts.area(b); });
+    t.sort_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    Shelf shelf{2440, 1220};
+    std::vector<Placement> placements(parts.size());
+    for (uint32_t i : order) {
+        double w = parts.width[i];
+        double h = parts.height[i];
+        if ((parts.rotations[i] & ROTATE_90) && parts.height[i] > parts.width[i]) std::swap(w, h);
+        Placement& placement = placements[i];
+        placement.part = i;
+        shelf.place(w, h, placement.x, placement.y, placement.board_id);
+    }
+    t.sweep_ms = elapsed_ms(start);
+
+    for (const auto& p : placements) t.checksum += p.x + p.y + p.board_id;
+    return t;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = 50000;
+    int repeat = 5;
+    std::string layout = "both";
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--parts") == 0 && i + 1 < argc) {
+            count = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            layout = argv[++i];
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: nester_bench_layout [--parts N] [--layout aos|soa|both] [--repeat R]\n");
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> size_dist(50, 1200);
+    std::vector<Part> input(count);
+    for (size_t i = 0; i < count; i++) {
+        input[i].width = size_dist(rng);
+        input[i].height = size_dist(rng);
+        input[i].id = static_cast<StringId>(i);
+        input[i].grain = static_cast<GrainId>(rng() % 3 == 0);
+    }
+
+    std::printf("layout,parts,repeat,sort_ms,sweep_ms,checksum\n");
+    for (const char* name : {"aos", "soa"}) {
+        if (layout != "both" && layout != name) continue;
+        Timing best;
+        for (int r = 0; r < repeat; r++) {
+            Timing t = std::strcmp(name, "aos") == 0 ? run_aos(input) : run_soa(input);
+            if (r == 0 || t.sort_ms + t.sweep_ms < best.sort_ms + best.sweep_ms) best = t;
+        }
+        std::printf("%s,%zu,%d,%.3f,%.3f,%.0f\n", name, count, repeat, best.sort_ms, best.sweep_ms, best.checksum);
+    }
+    return 0;
+}
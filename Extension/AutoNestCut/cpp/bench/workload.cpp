@@ -0,0 +1,299 @@
+#include "workload.h"
+#include "json_writer.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace AutoNestCut {
+
+namespace {
+
+// Material roles in the cabinet workloads. With fewer materials than roles
+// they share materials; extra materials become additional door finishes.
+enum Role { CARCASS = 0, BACK = 1, FRONT = 2 };
+
+struct MaterialSpec {
+    const char* name;
+    double width;
+    double height;
+    double thickness;
+};
+
+const MaterialSpec CARCASS_MATERIAL = {"White_Melamine_18mm", 2800, 2070, 18};
+const MaterialSpec BACK_MATERIAL = {"HDF_Back_3mm", 2440, 1220, 3};
+const MaterialSpec FRONT_MATERIAL = {"Oak_Veneer_18mm", 2440, 1220, 18};
+
+class Generator {
+public:
+    explicit Generator(const WorkloadSpec& spec)
+        : spec_(spec), rng_(spec.seed), material_count_(std::max<size_t>(spec.materials, 1)) {
+        workload_.kerf = spec.kerf;
+        for (size_t m = 0; m < material_count_; m++) {
+            MaterialSpec base = m == CARCASS ? CARCASS_MATERIAL : m == BACK ? BACK_MATERIAL : FRONT_MATERIAL;
+            std::string name = base.name;
+            if (m > FRONT) name = "Finish_" + std::to_string(m - FRONT) + "_18mm";
+            workload_.boards.push_back({name, base.width, base.height});
+            thickness_.push_back(base.thickness);
+        }
+    }
+
+    Workload run() {
+        workload_.parts.reserve(spec_.parts + 32);
+        while (workload_.parts.size() < spec_.parts) {
+            switch (spec_.kind) {
+                case WorkloadKind::KITCHEN: kitchen_cabinet(); break;
+                case WorkloadKind::WARDROBE: wardrobe(); break;
+                case WorkloadKind::SHELVING: shelving_unit(); break;
+                case WorkloadKind::UNIFORM: uniform_part(); break;
+                case WorkloadKind::HEAVY_TAILED: heavy_tailed_part(); break;
+            }
+            unit_++;
+        }
+        workload_.parts.resize(spec_.parts);
+        return std::move(workload_);
+    }
+
+private:
+    const WorkloadSpec& spec_;
+    std::mt19937_64 rng_;
+    size_t material_count_;
+    Workload workload_;
+    std::vector<double> thickness_;
+    size_t unit_ = 0;
+
+    template <typename T>
+    T pick(std::initializer_list<T> values) {
+        return values.begin()[rng_() % values.size()];
+    }
+
+    // Built from the raw engine output rather than a std distribution, whose
+    // algorithm differs between standard libraries, so a seed gives the same
+    // workload everywhere
+    double uniform(double lo, double hi) {
+        return lo + (hi - lo) * (static_cast<double>(rng_() >> 11) * 0x1.0p-53);
+    }
+
+    bool chance(double p) { return uniform(0, 1) < p; }
+
+    size_t material_for(Role role) const {
+        if (role == FRONT && material_count_ > FRONT + 1) {
+            return FRONT + unit_ % (material_count_ - FRONT); // One finish per cabinet
+        }
+        return static_cast<size_t>(role) % material_count_;
+    }
+
+    // Grain for independent parts: mostly free, some constrained
+    const char* random_grain() {
+        double p = uniform(0, 1);
+        if (p < 0.6) return "any";
+        if (p < 0.85) return "vertical";
+        if (p < 0.95) return "horizontal";
+        return "fixed";
+    }
+
+    // Add `count` copies of a part. Sizes are clamped so the part fits its
+    // board (with kerf) in an allowed orientation; parts that may not rotate
+    // are laid out with their long side along the board's width.
+    void add(const char* unit, const char* name, size_t material, double length, double width,
+             const char* grain, int count = 1) {
+        const WorkloadBoard& board = workload_.boards[material];
+        double max_long = std::max(board.width, board.height) - spec_.kerf;
+        double max_short = std::min(board.width, board.height) - spec_.kerf;
+        double a = std::round(std::max(length, width));
+        double b = std::round(std::min(length, width));
+        a = std::clamp(a, 20.0, max_long);
+        b = std::clamp(b, 20.0, std::min(a, max_short));
+
+        bool rotates = std::string_view(grain) == "any";
+        double part_width = rotates && chance(0.5) ? b : a;
+        double part_height = part_width == a ? b : a;
+        if (!rotates && board.width < board.height) std::swap(part_width, part_height);
+
+        for (int i = 0; i < count; i++) {
+            WorkloadPart part;
+            part.id = std::string(unit) + std::to_string(unit_) + "_" + name + "_" +
+                      std::to_string(workload_.parts.size());
+            part.name = name;
+            part.material = board.material;
+            part.width = part_width;
+            part.height = part_height;
+            part.thickness = thickness_[material];
+            part.grain_direction = grain;
+            workload_.parts.push_back(std::move(part));
+        }
+    }
+
+    void kitchen_cabinet() {
+        size_t carcass = material_for(CARCASS);
+        size_t back = material_for(BACK);
+        size_t front = material_for(FRONT);
+        // Wood-grain carcass decors must keep their grain direction
+        const char* carcass_grain = chance(0.3) ? "vertical" : "any";
+        double t = thickness_[carcass];
+
+        double p = uniform(0, 1);
+        if (p < 0.5) {
+            // Base cabinet, with doors or a drawer stack
+            double w = pick({300.0, 400.0, 450.0, 500.0, 600.0, 800.0, 900.0, 1000.0});
+            double h = 720;
+            double d = 560;
+            add("base", "side", carcass, h, d, carcass_grain, 2);
+            add("base", "bottom", carcass, w - 2 * t, d, carcass_grain);
+            add("base", "rail", carcass, w - 2 * t, 100, "any", 2);
+            add("base", "back", back, h, w, "any");
+            if (chance(0.3)) {
+                add("base", "drawer_front", front, w - 4, 236, "horizontal", 3);
+                add("base", "drawer_side", carcass, d - 60, 150, "any", 6);
+                add("base", "drawer_end", carcass, w - 2 * t - 50, 150, "any", 6);
+                add("base", "drawer_bottom", back, d - 60, w - 2 * t - 40, "any", 3);
+            } else {
+                add("base", "shelf", carcass, w - 2 * t - 2, d - 20, carcass_grain);
+                int doors = w <= 600 ? 1 : 2;
+                add("base", "door", front, h - 4, w / doors - 4, "vertical", doors);
+            }
+        } else if (p < 0.85) {
+            double w = pick({300.0, 400.0, 500.0, 600.0, 800.0, 900.0});
+            double h = pick({720.0, 900.0});
+            double d = 320;
+            add("wall", "side", carcass, h, d, carcass_grain, 2);
+            add("wall", "top", carcass, w - 2 * t, d, carcass_grain, 2);
+            add("wall", "shelf", carcass, w - 2 * t - 2, d - 20, carcass_grain, h > 800 ? 2 : 1);
+            add("wall", "back", back, h, w, "any");
+            int doors = w <= 600 ? 1 : 2;
+            add("wall", "door", front, h - 4, w / doors - 4, "vertical", doors);
+        } else {
+            double w = pick({450.0, 600.0});
+            double h = 2100;
+            double d = 560;
+            add("tall", "side", carcass, h, d, carcass_grain, 2);
+            add("tall", "top", carcass, w - 2 * t, d, carcass_grain, 2);
+            add("tall", "shelf", carcass, w - 2 * t - 2, d - 20, carcass_grain, 4);
+            add("tall", "back", back, h, w, "any");
+            add("tall", "door", front, 1300, w - 4, "vertical");
+            add("tall", "door", front, h - 1304, w - 4, "vertical");
+        }
+    }
+
+    void wardrobe() {
+        size_t carcass = material_for(CARCASS);
+        size_t back = material_for(BACK);
+        size_t front = material_for(FRONT);
+        const char* carcass_grain = chance(0.4) ? "vertical" : "any";
+        double t = thickness_[carcass];
+
+        double w = pick({500.0, 600.0, 800.0, 900.0, 1000.0, 1150.0});
+        double h = pick({2000.0, 2200.0, 2300.0});
+        double d = 600;
+        add("wardrobe", "side", carcass, h, d, carcass_grain, 2);
+        add("wardrobe", "top", carcass, w - 2 * t, d, carcass_grain, 2);
+        double bay = w - 2 * t;
+        if (w > 900) {
+            add("wardrobe", "divider", carcass, h - 2 * t, d - 20, carcass_grain);
+            bay = (w - 3 * t) / 2;
+        }
+        int shelves = 3 + static_cast<int>(rng_() % 4);
+        add("wardrobe", "shelf", carcass, bay - 2, d - 20, carcass_grain, shelves);
+        add("wardrobe", "back", back, h, w, "any");
+        int doors = w <= 600 ? 1 : 2;
+        add("wardrobe", "door", front, h - 4, w / doors - 4, "vertical", doors);
+    }
+
+    // A few fixed presets, so the same sizes repeat many times
+    void shelving_unit() {
+        struct Preset { double width, height, depth; int shelves; };
+        static const Preset presets[] = {
+            {600, 1800, 300, 5}, {800, 2000, 300, 6}, {800, 2000, 400, 6}, {1000, 1800, 400, 4},
+        };
+        const Preset& preset = presets[rng_() % 4];
+        size_t carcass = material_count_ > FRONT ? FRONT + unit_ % (material_count_ - FRONT) : size_t(CARCASS);
+        size_t back = material_for(BACK);
+        double t = thickness_[carcass];
+
+        add("shelving", "side", carcass, preset.height, preset.depth, "vertical", 2);
+        add("shelving", "top", carcass, preset.width - 2 * t, preset.depth, "any", 2);
+        add("shelving", "shelf", carcass, preset.width - 2 * t - 2, preset.depth - 20, "any", preset.shelves);
+        add("shelving", "back", back, preset.height, preset.width, "any");
+    }
+
+    void uniform_part() {
+        size_t material = rng_() % material_count_;
+        add("rect", "panel", material, uniform(50, 1200), uniform(50, 1200), random_grain());
+    }
+
+    // Pareto-distributed long side (most parts small, a few near board size)
+    void heavy_tailed_part() {
+        size_t material = rng_() % material_count_;
+        const double scale = 80;
+        const double alpha = 1.3;
+        double length = scale / std::pow(1.0 - uniform(0, 1), 1.0 / alpha);
+        double width = std::max(30.0, length * uniform(0.15, 1.0));
+        add("rect", "panel", material, length, width, random_grain());
+    }
+};
+
+} // namespace
+
+const char* workload_kind_name(WorkloadKind kind) {
+    switch (kind) {
+        case WorkloadKind::KITCHEN: return "kitchen";
+        case WorkloadKind::WARDROBE: return "wardrobe";
+        case WorkloadKind::SHELVING: return "shelving";
+        case WorkloadKind::UNIFORM: return "uniform";
+        case WorkloadKind::HEAVY_TAILED: return "heavy-tailed";
+    }
+    return "unknown";
+}
+
+bool parse_workload_kind(std::string_view name, WorkloadKind& kind) {
+    for (WorkloadKind k : {WorkloadKind::KITCHEN, WorkloadKind::WARDROBE, WorkloadKind::SHELVING,
+                           WorkloadKind::UNIFORM, WorkloadKind::HEAVY_TAILED}) {
+        if (name == workload_kind_name(k)) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+Workload generate_workload(const WorkloadSpec& spec) {
+    return Generator(spec).run();
+}
+
+bool write_workload(std::FILE* file, const Workload& workload) {
+    JsonWriter json(file);
+    json.begin_object();
+
+    json.key("settings").begin_object()
+        .member("kerf", workload.kerf)
+        .member("allow_rotation", true)
+        .end_object();
+
+    json.key("boards").begin_array();
+    for (const auto& board : workload.boards) {
+        json.begin_object()
+            .member("material", board.material)
+            .member("width", board.width)
+            .member("height", board.height)
+            .end_object();
+    }
+    json.end_array();
+
+    json.key("parts").begin_array();
+    for (const auto& part : workload.parts) {
+        json.begin_object()
+            .member("id", part.id)
+            .member("name", part.name)
+            .member("material", part.material)
+            .member("width", part.width)
+            .member("height", part.height)
+            .member("thickness", part.thickness)
+            .member("grain_direction", part.grain_direction)
+            .end_object();
+    }
+    json.end_array();
+
+    json.end_object();
+    return json.flush();
+}
+
+} // namespace AutoNestCut
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Synthetic nesting jobs for benchmarking. The same kind, part count,
+// material count and seed always give the same job.
+enum class WorkloadKind {
+    KITCHEN,      // Base, wall and tall cabinets: carcass, back and door parts
+    WARDROBE,     // Tall carcasses with shelves, dividers and full-height doors
+    SHELVING,     // Shelving units built from a handful of repeated sizes
+    UNIFORM,      // Independent uniform random rectangles
+    HEAVY_TAILED, // Mostly small parts with a Pareto tail of large panels
+};
+
+struct WorkloadSpec {
+    WorkloadKind kind = WorkloadKind::KITCHEN;
+    size_t parts = 1000;
+    size_t materials = 3;
+    uint64_t seed = 1;
+    double kerf = 3.0;
+};
+
+struct WorkloadBoard {
+    std::string material;
+    double width;
+    double height;
+};
+
+struct WorkloadPart {
+    std::string id;
+    std::string name;
+    std::string material;
+    double width;
+    double height;
+    double thickness;
+    const char* grain_direction; // "any", "vertical", "horizontal" or "fixed"
+};
+
+struct Workload {
+    double kerf = 3.0;
+    std::vector<WorkloadBoard> boards;
+    std::vector<WorkloadPart> parts;
+};
+
+const char* workload_kind_name(WorkloadKind kind);
+bool parse_workload_kind(std::string_view name, WorkloadKind& kind);
+
+// Every part fits its material's board in at least one allowed orientation
+Workload generate_workload(const WorkloadSpec& spec);
+
+// Write as a JSON request in the nester's input format
+bool write_workload(std::FILE* file, const Workload& workload);
+
+} // namespace AutoNestCut
@@ -14,10 +14,24 @@ if errorlevel 1 (
 )
 
 echo Compiling...
-g++ -std=c++17 -O3 -Wall -Wextra ^
+g++ -std=c++17 -O3 -Wall -Wextra -pthread ^
     src/main.cpp ^
     src/nesting.cpp ^
     src/geometry.cpp ^
+    src/alloc_tracker.cpp ^
+    src/binary_format.cpp ^
+    src/input_source.cpp ^
+    src/json_reader.cpp ^
+    src/json_writer.cpp ^
+    src/part_store.cpp ^
+    src/perf_counters.cpp ^
+    src/replay_log.cpp ^
+    src/request.cpp ^
+    src/result_cache.cpp ^
+    src/session.cpp ^
+    src/solution.cpp ^
+    src/string_table.cpp ^
+    src/trace.cpp ^
     -o nester.exe
 
 if errorlevel 1 (
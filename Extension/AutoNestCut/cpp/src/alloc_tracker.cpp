@@ -0,0 +1,175 @@
+#include "alloc_tracker.h"
+#include "profile.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if AUTONESTCUT_PROFILE
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#endif
+
+namespace AutoNestCut {
+
+#if AUTONESTCUT_PROFILE
+
+namespace {
+
+std::atomic<bool> tracking{false};
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> frees{0};
+std::atomic<uint64_t> bytes{0};
+std::atomic<int64_t> live_bytes{0}; // Can dip below 0 freeing older memory
+std::atomic<int64_t> peak_live_bytes{0};
+
+size_t usable_size(void* ptr, size_t alignment) {
+#if defined(_WIN32)
+    return alignment > 0 ? _aligned_msize(ptr, alignment, 0) : _msize(ptr);
+#elif defined(__APPLE__)
+    (void)alignment;
+    return malloc_size(ptr);
+#else
+    (void)alignment;
+    return malloc_usable_size(ptr);
+#endif
+}
+
+void record_allocation(void* ptr, size_t size, size_t alignment) {
+    if (!tracking.load(std::memory_order_relaxed)) return;
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    int64_t usable = static_cast<int64_t>(usable_size(ptr, alignment));
+    int64_t live = live_bytes.fetch_add(usable, std::memory_order_relaxed) + usable;
+    int64_t peak = peak_live_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void record_free(void* ptr, size_t alignment) {
+    if (!ptr || !tracking.load(std::memory_order_relaxed)) return;
+    frees.fetch_add(1, std::memory_order_relaxed);
+    live_bytes.fetch_sub(static_cast<int64_t>(usable_size(ptr, alignment)), std::memory_order_relaxed);
+}
+
+// alignment 0 means the default new alignment
+void* allocate(size_t size, size_t alignment) {
+    if (size == 0) size = 1;
+    for (;;) {
+        void* ptr;
+#if defined(_WIN32)
+        ptr = alignment > 0 ? _aligned_malloc(size, alignment) : std::malloc(size);
+#else
+        ptr = alignment > 0 ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                            : std::malloc(size);
+#endif
+        if (ptr) {
+            record_allocation(ptr, size, alignment);
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* allocate_nothrow(size_t size, size_t alignment) noexcept {
+    try {
+        return allocate(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void deallocate(void* ptr, size_t alignment) noexcept {
+    record_free(ptr, alignment);
+#if defined(_WIN32)
+    if (alignment > 0) {
+        _aligned_free(ptr);
+        return;
+    }
+#endif
+    std::free(ptr);
+}
+
+} // namespace
+
+bool enable_alloc_tracking() {
+    tracking.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool alloc_tracking_enabled() {
+    return tracking.load(std::memory_order_relaxed);
+}
+
+AllocSample alloc_snapshot() {
+    AllocSample sample;
+    sample.allocations = allocations.load(std::memory_order_relaxed);
+    sample.frees = frees.load(std::memory_order_relaxed);
+    sample.bytes = bytes.load(std::memory_order_relaxed);
+    return sample;
+}
+
+uint64_t alloc_peak_live_bytes() {
+    return static_cast<uint64_t>(peak_live_bytes.load(std::memory_order_relaxed));
+}
+
+#else
+
+bool enable_alloc_tracking() { return false; }
+bool alloc_tracking_enabled() { return false; }
+AllocSample alloc_snapshot() { return AllocSample(); }
+uint64_t alloc_peak_live_bytes() { return 0; }
+
+#endif
+
+} // namespace AutoNestCut
+
+#if AUTONESTCUT_PROFILE
+
+// Replacement global allocation functions. They are linked in with this
+// object, i.e. into programs that call enable_alloc_tracking().
+using AutoNestCut::allocate;
+using AutoNestCut::allocate_nothrow;
+using AutoNestCut::deallocate;
+
+void* operator new(size_t size) { return allocate(size, 0); }
+void* operator new[](size_t size) { return allocate(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate_nothrow(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate_nothrow(size, 0); }
+void* operator new(size_t size, std::align_val_t align) { return allocate(size, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return allocate(size, static_cast<size_t>(align)); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return allocate_nothrow(size, static_cast<size_t>(align));
+}
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return allocate_nothrow(size, static_cast<size_t>(align));
+}
+
+void operator delete(void* ptr) noexcept { deallocate(ptr, 0); }
+void operator delete[](void* ptr) noexcept { deallocate(ptr, 0); }
+void operator delete(void* ptr, size_t) noexcept { deallocate(ptr, 0); }
+void operator delete[](void* ptr, size_t) noexcept { deallocate(ptr, 0); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { deallocate(ptr, 0); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { deallocate(ptr, 0); }
+void operator delete(void* ptr, std::align_val_t align) noexcept { deallocate(ptr, static_cast<size_t>(align)); }
+void operator delete[](void* ptr, std::align_val_t align) noexcept { deallocate(ptr, static_cast<size_t>(align)); }
+void operator delete(void* ptr, size_t, std::align_val_t align) noexcept {
+    deallocate(ptr, static_cast<size_t>(align));
+}
+void operator delete[](void* ptr, size_t, std::align_val_t align) noexcept {
+    deallocate(ptr, static_cast<size_t>(align));
+}
+void operator delete(void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept {
+    deallocate(ptr, static_cast<size_t>(align));
+}
+void operator delete[](void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept {
+    deallocate(ptr, static_cast<size_t>(align));
+}
+
+#endif
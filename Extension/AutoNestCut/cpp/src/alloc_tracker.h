@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+namespace AutoNestCut {
+
+// Heap activity over an interval, from the counting global operator
+// new/delete in alloc_tracker.cpp
+struct AllocSample {
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0; // Requested by the allocations
+
+    AllocSample& operator+=(const AllocSample& other) {
+        allocations += other.allocations;
+        frees += other.frees;
+        bytes += other.bytes;
+        return *this;
+    }
+
+    AllocSample operator-(const AllocSample& other) const {
+        AllocSample diff;
+        diff.allocations = allocations - other.allocations;
+        diff.frees = frees - other.frees;
+        diff.bytes = bytes - other.bytes;
+        return diff;
+    }
+};
+
+// Start counting; until then operator new/delete only check a flag.
+// Returns false in builds without profiling support.
+bool enable_alloc_tracking();
+bool alloc_tracking_enabled();
+
+// Totals since tracking started, over all threads
+AllocSample alloc_snapshot();
+
+// Highest number of live heap bytes (allocator usable size) since tracking
+// started; memory allocated earlier is not included
+uint64_t alloc_peak_live_bytes();
+
+} // namespace AutoNestCut
@@ -0,0 +1,267 @@
+#include "binary_format.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace AutoNestCut {
+
+namespace {
+
+const char REQUEST_MAGIC[4] = {'A', 'N', 'C', 'Q'};
+const char RESPONSE_MAGIC[4] = {'A', 'N', 'C', 'R'};
+
+bool host_is_little_endian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+size_t padded(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+// Bounds-checked sequential reader over the request bytes
+class SectionReader {
+public:
+    SectionReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    const char* take(size_t bytes) {
+        if (bytes > size_ - pos_) return nullptr;
+        const char* p = data_ + pos_;
+        pos_ += bytes;
+        return p;
+    }
+
+    template <typename T>
+    bool read_array(std::vector<T>& out, size_t count) {
+        if (count > (size_ - pos_) / sizeof(T)) return false;
+        out.resize(count);
+        if (count > 0) std::memcpy(out.data(), data_ + pos_, count * sizeof(T));
+        pos_ += count * sizeof(T);
+        return true;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+bool write_block(std::FILE* file, const void* data, size_t bytes) {
+    return bytes == 0 || std::fwrite(data, 1, bytes, file) == bytes;
+}
+
+} // namespace
+
+bool read_binary_request(const char* data, size_t size, NestRequest& request, std::string& error) {
+    if (!host_is_little_endian()) {
+        error = "Binary format requires a little-endian host";
+        return false;
+    }
+
+    SectionReader reader(data, size);
+    Binary::Header header;
+    const char* header_bytes = reader.take(sizeof(header));
+    if (!header_bytes) {
+        error = "Binary request is truncated";
+        return false;
+    }
+    std::memcpy(&header, header_bytes, sizeof(header));
+
+    if (std::memcmp(header.magic, REQUEST_MAGIC, 4) != 0) {
+        error = "Not a binary nesting request";
+        return false;
+    }
+    if (header.version != Binary::VERSION && header.version != 1) {
+        error = "Unsupported binary request version " + std::to_string(header.version);
+        return false;
+    }
+
+    std::vector<Binary::StringRef> refs;
+    const char* string_bytes = nullptr;
+    std::vector<Binary::Board> boards;
+    std::vector<Binary::PartType> part_types;
+
+    // Version 1 settings end before min_offcut_size
+    Binary::Settings settings{};
+    settings.min_offcut_size = request.settings.min_offcut_size;
+    const size_t settings_size = header.version == 1 ? offsetof(Binary::Settings, min_offcut_size)
+                                                     : sizeof(Binary::Settings);
+    const char* settings_bytes = nullptr;
+
+    if (!reader.read_array(refs, header.string_count) ||
+        !(string_bytes = reader.take(header.string_bytes)) ||
+        !(settings_bytes = reader.take(settings_size)) ||
+        !reader.read_array(boards, header.board_count) ||
+        !reader.read_array(part_types, header.part_type_count)) {
+        error = "Binary request is truncated";
+        return false;
+    }
+
+    std::vector<std::string_view> strings;
+    strings.reserve(refs.size());
+    for (const auto& ref : refs) {
+        if (ref.offset > header.string_bytes || ref.length > header.string_bytes - ref.offset) {
+            error = "Binary request has an invalid string table";
+            return false;
+        }
+        strings.emplace_back(string_bytes + ref.offset, ref.length);
+    }
+
+    auto lookup = [&](uint32_t index, std::string_view fallback, std::string_view& out) {
+        if (index == Binary::NO_STRING) {
+            out = fallback;
+            return true;
+        }
+        if (index >= strings.size()) return false;
+        out = strings[index];
+        return true;
+    };
+
+    std::memcpy(&settings, settings_bytes, settings_size);
+    request.settings.kerf_width = settings.kerf;
+    request.settings.allow_rotation = settings.allow_rotation != 0;
+    request.settings.timeout_ms = settings.timeout_ms;
+    request.settings.min_offcut_size = settings.min_offcut_size;
+
+    for (const auto& board : boards) {
+        std::string_view material;
+        if (!lookup(board.material, "", material)) {
+            error = "Binary request has an invalid board material";
+            return false;
+        }
+        request.board_sizes[request.material_id(material)] = {board.width, board.height};
+    }
+
+    for (uint32_t t = 0; t < part_types.size(); t++) {
+        const auto& type = part_types[t];
+        if (type.quantity > Binary::MAX_PARTS - request.part_count) {
+            error = "Binary request has too many parts (max " + std::to_string(Binary::MAX_PARTS) + ")";
+            return false;
+        }
+        std::string_view id;
+        std::string_view material;
+        std::string_view grain;
+        if (!lookup(type.id, "", id) ||
+            !lookup(type.material, "", material) ||
+            !lookup(type.grain_direction, "any", grain)) {
+            error = "Binary request has an invalid part type";
+            return false;
+        }
+
+        Part part;
+        part.width = type.width;
+        part.height = type.height;
+        part.material = request.material_id(material);
+        part.grain = request.grain_id(grain.empty() ? "any" : grain);
+        part.type_index = t;
+
+        auto& pool = request.parts_by_material[part.material];
+        pool.reserve(pool.size() + type.quantity);
+        for (uint32_t n = 0; n < type.quantity; n++) {
+            part.instance = n;
+            if (type.quantity > 1) {
+                part.id = request.part_ids.add(std::string(id) + "#" + std::to_string(n + 1));
+            } else {
+                part.id = request.part_ids.add(id);
+            }
+            pool.add(part);
+        }
+        request.part_count += type.quantity;
+    }
+    if (request.too_many_materials()) {
+        error = "Binary request has too many materials (max " + std::to_string(MAX_MATERIALS) + ")";
+        return false;
+    }
+    if (request.too_many_grains()) {
+        error = "Binary request has too many grain directions (max " + std::to_string(MAX_GRAINS) + ")";
+        return false;
+    }
+
+    assign_rotations(request);
+    return true;
+}
+
+bool write_binary_response(const std::string& path, const Solution& solution,
+                           const NestRequest& request, long long time_ms, std::string& error) {
+    if (!host_is_little_endian()) {
+        error = "Binary format requires a little-endian host";
+        return false;
+    }
+
+    StringTable strings;
+    std::vector<Binary::BoardResult> board_results;
+    std::vector<Binary::Placement> placements;
+    board_results.reserve(solution.boards.size());
+    placements.reserve(solution.placements.size());
+
+    for (const auto& board : solution.boards) {
+        Binary::BoardResult result{};
+        result.id = board.id;
+        result.material = strings.intern(request.materials.get(board.material));
+        result.parts_count = board.placement_count;
+        result.width = board.width;
+        result.height = board.height;
+        result.used_area = board.used_area();
+        result.waste_percentage = board.waste_percentage();
+        board_results.push_back(result);
+    }
+
+    for (const auto& placed : solution.placements) {
+        const PartStore& parts = request.parts_by_material[placed.material];
+        Binary::Placement placement{};
+        placement.part_type = parts.type_index[placed.part];
+        placement.instance = parts.instance[placed.part];
+        placement.board_id = placed.board_id;
+        placement.rotation = placed.rotation;
+        placement.x = placed.x;
+        placement.y = placed.y;
+        placements.push_back(placement);
+    }
+
+    // String table: index plus bytes padded to keep the next sections aligned
+    std::vector<Binary::StringRef> string_refs;
+    std::vector<char> string_bytes;
+    for (StringId i = 0; i < strings.size(); i++) {
+        std::string_view str = strings.get(i);
+        string_refs.push_back({static_cast<uint32_t>(string_bytes.size()), static_cast<uint32_t>(str.size())});
+        string_bytes.insert(string_bytes.end(), str.begin(), str.end());
+    }
+    string_bytes.resize(padded(string_bytes.size()), '\0');
+
+    Binary::Header header{};
+    std::memcpy(header.magic, RESPONSE_MAGIC, 4);
+    header.version = Binary::VERSION;
+    header.string_count = static_cast<uint32_t>(string_refs.size());
+    header.string_bytes = static_cast<uint32_t>(string_bytes.size());
+    header.board_count = static_cast<uint32_t>(board_results.size());
+    header.placement_count = static_cast<uint32_t>(placements.size());
+
+    Binary::Stats stats{};
+    stats.time_ms = time_ms;
+    stats.boards_used = static_cast<uint32_t>(solution.boards.size());
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "Cannot open output file: " + path;
+        return false;
+    }
+
+    bool written =
+        write_block(file, &header, sizeof(header)) &&
+        write_block(file, string_refs.data(), string_refs.size() * sizeof(Binary::StringRef)) &&
+        write_block(file, string_bytes.data(), string_bytes.size()) &&
+        write_block(file, &stats, sizeof(stats)) &&
+        write_block(file, board_results.data(), board_results.size() * sizeof(Binary::BoardResult)) &&
+        write_block(file, placements.data(), placements.size() * sizeof(Binary::Placement));
+
+    if (std::fclose(file) != 0) written = false;
+    if (!written) {
+        error = "Failed to write output file: " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace AutoNestCut
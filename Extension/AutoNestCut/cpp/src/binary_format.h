@@ -0,0 +1,122 @@
+#pragma once
+
+#include "nesting.h"
+#include "request.h"
+#include "solution.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Compact binary wire format, used alongside JSON (which stays available for
+// debugging). All integers and doubles are little-endian and every record has
+// a fixed width, so each section can be memcpy'd straight into an array of the
+// structs below without any parsing.
+//
+// Request  ("ANCQ"): header | string index | string bytes | settings |
+//                    boards[board_count] | part_types[part_type_count]
+// Response ("ANCR"): header | string index | string bytes | stats |
+//                    boards[board_count] | placements[placement_count]
+//
+// The string bytes are padded to a multiple of 8 so every following section
+// stays 8-byte aligned. Strings (materials, grain directions, part IDs) are
+// interned: records refer to them by index into the string index.
+namespace Binary {
+
+// Version 2 added min_offcut_size to Settings; version 1 requests, with the
+// 16-byte settings record, are still read
+constexpr uint16_t VERSION = 2;
+constexpr uint32_t NO_STRING = 0xFFFFFFFFu;
+
+// Most part instances a request may expand to, over all its part types
+constexpr uint32_t MAX_PARTS = 10000000;
+
+struct Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t string_count;
+    uint32_t string_bytes;
+    uint32_t board_count;
+    uint32_t part_type_count;
+    uint32_t placement_count;
+    uint32_t reserved;
+};
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct Settings {
+    double kerf;
+    uint32_t allow_rotation;
+    int32_t timeout_ms;
+    double min_offcut_size;
+};
+
+struct Board {
+    uint32_t material;
+    uint32_t reserved;
+    double width;
+    double height;
+};
+
+// One row per distinct part; `quantity` instances are nested
+struct PartType {
+    uint32_t id;
+    uint32_t material;
+    uint32_t grain_direction; // NO_STRING means "any"
+    uint32_t quantity;
+    double width;
+    double height;
+};
+
+struct Stats {
+    int64_t time_ms;
+    uint32_t boards_used;
+    uint32_t reserved;
+};
+
+struct BoardResult {
+    int32_t id;
+    uint32_t material;
+    uint32_t parts_count;
+    uint32_t reserved;
+    double width;
+    double height;
+    double used_area;
+    double waste_percentage;
+};
+
+struct Placement {
+    uint32_t part_type;
+    uint32_t instance;
+    int32_t board_id;
+    int32_t rotation;
+    double x;
+    double y;
+};
+
+static_assert(sizeof(Header) == 32, "binary header layout");
+static_assert(sizeof(StringRef) == 8, "binary string layout");
+static_assert(sizeof(Settings) == 24, "binary settings layout");
+static_assert(sizeof(Board) == 24, "binary board layout");
+static_assert(sizeof(PartType) == 32, "binary part type layout");
+static_assert(sizeof(Stats) == 16, "binary stats layout");
+static_assert(sizeof(BoardResult) == 48, "binary board result layout");
+static_assert(sizeof(Placement) == 32, "binary placement layout");
+
+} // namespace Binary
+
+// Decode a binary request. Part types are expanded into `quantity` Part
+// instances; instances of a type with quantity > 1 get "<id>#<n>" IDs so the
+// JSON output stays unambiguous.
+bool read_binary_request(const char* data, size_t size, NestRequest& request, std::string& error);
+
+// Encode the nesting result as a binary response
+bool write_binary_response(const std::string& path, const Solution& solution,
+                           const NestRequest& request, long long time_ms, std::string& error);
+
+} // namespace AutoNestCut
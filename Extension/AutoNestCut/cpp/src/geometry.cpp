@@ -11,8 +11,8 @@ bool intersects(const Rect& r1, const Rect& r2) {
              r2.bottom() <= r1.y);
 }
 
-std::vector<Rect> subtract_rect(const Rect& original, const Rect& to_subtract) {
-    std::vector<Rect> result;
+int subtract_rect(const Rect& original, const Rect& to_subtract, Rect out[4]) {
+    int count = 0;
     
     // Calculate intersection bounds
     double ix1 = std::max(original.x, to_subtract.x);
@@ -22,15 +22,15 @@ std::vector<Rect> subtract_rect(const Rect& original, const Rect& to_subtract) {
     
     // No intersection - return original
     if (ix2 <= ix1 || iy2 <= iy1) {
-        result.push_back(original);
-        return result;
+        out[0] = original;
+        return 1;
     }
     
     // Create up to 4 rectangles around the intersection
     
     // 1. Left piece (to the left of intersection)
     if (original.x < ix1) {
-        result.emplace_back(
+        out[count++] = Rect(
             original.x, 
             original.y, 
             ix1 - original.x, 
@@ -40,7 +40,7 @@ std::vector<Rect> subtract_rect(const Rect& original, const Rect& to_subtract) {
     
     // 2. Right piece (to the right of intersection)
     if (original.right() > ix2) {
-        result.emplace_back(
+        out[count++] = Rect(
             ix2, 
             original.y, 
             original.right() - ix2, 
@@ -50,7 +50,7 @@ std::vector<Rect> subtract_rect(const Rect& original, const Rect& to_subtract) {
     
     // 3. Bottom piece (below intersection, constrained by intersection X-bounds)
     if (original.y < iy1) {
-        result.emplace_back(
+        out[count++] = Rect(
             ix1, 
             original.y, 
             ix2 - ix1, 
@@ -60,7 +60,7 @@ std::vector<Rect> subtract_rect(const Rect& original, const Rect& to_subtract) {
     
     // 4. Top piece (above intersection, constrained by intersection X-bounds)
     if (original.bottom() > iy2) {
-        result.emplace_back(
+        out[count++] = Rect(
             ix1, 
             iy2, 
             ix2 - ix1, 
@@ -68,7 +68,7 @@ std::vector<Rect> subtract_rect(const Rect& original, const Rect& to_subtract) {
         );
     }
     
-    return result;
+    return count;
 }
 
 } // namespace AutoNestCut
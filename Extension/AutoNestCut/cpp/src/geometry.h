@@ -25,7 +25,8 @@ struct Rect {
 // Check if two rectangles intersect
 bool intersects(const Rect& r1, const Rect& r2);
 
-// Subtract r2 from r1, returning up to 4 new rectangles
-std::vector<Rect> subtract_rect(const Rect& original, const Rect& to_subtract);
+// Subtract to_subtract from original, writing up to 4 new rectangles to `out`.
+// Returns the number of rectangles written; no memory is allocated.
+int subtract_rect(const Rect& original, const Rect& to_subtract, Rect out[4]);
 
 } // namespace AutoNestCut
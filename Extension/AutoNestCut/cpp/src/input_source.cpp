@@ -0,0 +1,201 @@
+#include "input_source.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AutoNestCut {
+
+namespace {
+
+// Whatever input is available, up to `max` bytes; 0 at end of input or on an
+// error. Unlike fread() this does not wait for the whole block, so a short
+// request reaches the parser while the writer still holds the pipe open.
+size_t read_available(std::FILE* file, char* dst, size_t max) {
+#ifdef _WIN32
+    int n = _read(_fileno(file), dst, static_cast<unsigned>(std::min<size_t>(max, 1u << 30)));
+    return n > 0 ? static_cast<size_t>(n) : 0;
+#else
+    for (;;) {
+        ssize_t n = ::read(fileno(file), dst, max);
+        if (n >= 0) return static_cast<size_t>(n);
+        if (errno != EINTR) return 0;
+    }
+#endif
+}
+
+} // namespace
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+void MappedFile::close() {
+    if (mapped_ && data_) {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+#else
+        munmap(data_, size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    fallback_.clear();
+}
+
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "Cannot open input file: " + path;
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (mapping) {
+            void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+            if (view) {
+                data_ = static_cast<char*>(view);
+                size_ = static_cast<size_t>(file_size.QuadPart);
+                mapped_ = true;
+            }
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open input file: " + path;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t length = static_cast<size_t>(st.st_size);
+        void* view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+            madvise(view, length, MADV_SEQUENTIAL);
+#endif
+            data_ = static_cast<char*>(view);
+            size_ = length;
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    return mapped_ || read_fallback(path, error);
+}
+
+bool MappedFile::read_fallback(const std::string& path, std::string& error) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) {
+        error = "Cannot open input file: " + path;
+        return false;
+    }
+    fallback_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    return true;
+}
+
+PrefetchReader::PrefetchReader(std::FILE* file, size_t block_size, size_t max_blocks)
+    : shared_(std::make_shared<Shared>()) {
+    shared_->file = file;
+    shared_->block_size = block_size > 0 ? block_size : 1;
+    shared_->max_blocks = max_blocks > 0 ? max_blocks : 1;
+    worker_ = std::thread(&PrefetchReader::run, shared_);
+}
+
+PrefetchReader::~PrefetchReader() {
+    bool finished;
+    {
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        shared_->stop = true;
+        finished = shared_->finished;
+    }
+    shared_->slot_free.notify_all();
+    // Unless the thread is done, it may be blocked reading stdin, possibly for
+    // good (the writer waiting for our output); it sees the stop flag once the
+    // read returns and exits on its own
+    if (finished) {
+        worker_.join();
+    } else {
+        worker_.detach();
+    }
+}
+
+void PrefetchReader::run(std::shared_ptr<Shared> shared) {
+    // Reads from a pipe are often far shorter than a block; each is queued
+    // in a block of its own size
+    std::vector<char> buffer(shared->block_size);
+    const size_t max_buffered = shared->block_size * shared->max_blocks;
+    for (;;) {
+        size_t n = read_available(shared->file, buffer.data(), buffer.size());
+        std::vector<char> block(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(n));
+
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        shared->slot_free.wait(lock, [&] { return shared->stop || shared->buffered < max_buffered; });
+        if (shared->stop || n == 0) {
+            shared->eof = true;
+            shared->finished = true;
+            shared->block_ready.notify_one();
+            return;
+        }
+        shared->buffered += n;
+        shared->blocks.push_back(std::move(block));
+        shared->block_ready.notify_one();
+    }
+}
+
+size_t PrefetchReader::read(char* dst, size_t max) {
+    Shared& shared = *shared_;
+    size_t total = 0;
+    while (total < max) {
+        if (current_pos_ == current_.size()) {
+            std::unique_lock<std::mutex> lock(shared.mutex);
+            // Only block for more input if nothing has been copied yet
+            if (shared.blocks.empty() && (shared.eof || total > 0)) break;
+            shared.block_ready.wait(lock, [&] { return shared.eof || !shared.blocks.empty(); });
+            if (shared.blocks.empty()) break;
+            current_ = std::move(shared.blocks.front());
+            shared.blocks.pop_front();
+            shared.buffered -= current_.size();
+            current_pos_ = 0;
+            lock.unlock();
+            shared.slot_free.notify_one();
+        }
+
+        size_t n = std::min(max - total, current_.size() - current_pos_);
+        std::memcpy(dst + total, current_.data() + current_pos_, n);
+        current_pos_ += n;
+        total += n;
+    }
+    bytes_read_ += total;
+    return total;
+}
+
+} // namespace AutoNestCut
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "json_reader.h"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Read-only view of an input file for the in-situ parser.
+//
+// The file is memory-mapped copy-on-write (MAP_PRIVATE / FILE_MAP_COPY), so
+// the parser can decode escapes in place without touching the file on disk,
+// only the pages it writes to get private copies, and repeated runs on the
+// same file are served from the page cache. If mapping is not possible (pipes,
+// special files) the contents are read into an owned buffer instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+
+    char* data() { return data_; }
+    size_t size() const { return size_; }
+    bool is_mapped() const { return mapped_; }
+
+private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> fallback_;
+
+    void close();
+    bool read_fallback(const std::string& path, std::string& error);
+};
+
+// Reads a FILE* (typically stdin) on a background thread, so that parsing
+// overlaps with I/O. Each block holds whatever one read of the underlying
+// descriptor returned, up to `block_size` bytes, so input reaches the parser
+// as soon as it arrives (stdio buffering is bypassed: nothing may have been
+// read through the FILE* before). At most `max_blocks * block_size` bytes are
+// buffered at a time, which bounds memory no matter how large the input is.
+//
+// Destroying the reader never waits on I/O: if the thread has not finished
+// (the parse failed before the input ended) it is detached, and exits on its
+// own once its read returns.
+class PrefetchReader : public JsonInput {
+public:
+    PrefetchReader(std::FILE* file, size_t block_size = 1 << 20, size_t max_blocks = 4);
+    ~PrefetchReader() override;
+
+    PrefetchReader(const PrefetchReader&) = delete;
+    PrefetchReader& operator=(const PrefetchReader&) = delete;
+
+    size_t read(char* dst, size_t max) override;
+
+    // Total bytes handed to the parser so far
+    size_t bytes_read() const { return bytes_read_; }
+
+private:
+    // Shared with the reading thread, which may outlive the reader
+    struct Shared {
+        std::FILE* file;
+        size_t block_size;
+        size_t max_blocks;
+
+        std::mutex mutex;
+        std::condition_variable block_ready;
+        std::condition_variable slot_free;
+        std::deque<std::vector<char>> blocks;
+        size_t buffered = 0; // Bytes in `blocks`
+        bool eof = false;
+        bool stop = false;
+        bool finished = false; // The thread has returned, or is about to
+    };
+    std::shared_ptr<Shared> shared_;
+
+    // Block currently being consumed (owned by the parser thread)
+    std::vector<char> current_;
+    size_t current_pos_ = 0;
+    size_t bytes_read_ = 0;
+
+    std::thread worker_;
+
+    static void run(std::shared_ptr<Shared> shared);
+};
+
+} // namespace AutoNestCut
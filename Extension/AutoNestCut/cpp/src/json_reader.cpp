@@ -0,0 +1,382 @@
+#include "json_reader.h"
+#include <charconv>
+#include <cstring>
+
+namespace AutoNestCut {
+
+namespace {
+
+bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool read_hex4(const char* p, unsigned& out) {
+    out = 0;
+    for (int i = 0; i < 4; i++) {
+        int v = hex_value(p[i]);
+        if (v < 0) return false;
+        out = (out << 4) | static_cast<unsigned>(v);
+    }
+    return true;
+}
+
+// Encode a code point as UTF-8 at `out`, returning the number of bytes written
+size_t encode_utf8(unsigned cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (cp >> 18));
+    out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+} // namespace
+
+JsonReader::JsonReader(char* data, size_t size)
+    : begin_(data), cur_(data), end_(data + size) {}
+
+JsonReader::JsonReader(JsonInput& input, size_t window_size)
+    : input_(&input), window_(window_size > 16 ? window_size : 16) {
+    begin_ = cur_ = end_ = window_.data();
+}
+
+// Slide the window forward, keeping every byte from `keep` (and the pinned
+// position, if any) onwards, then read more input behind it. Pointers into the
+// window are rebased. Returns false at end of input or for contiguous buffers.
+bool JsonReader::refill(char*& keep) {
+    if (!input_) return false;
+
+    char* from = (pin_ && pin_ < keep) ? pin_ : keep;
+    size_t from_off = static_cast<size_t>(from - begin_);
+    size_t keep_off = static_cast<size_t>(keep - begin_);
+    size_t cur_off = static_cast<size_t>(cur_ - begin_);
+    size_t pin_off = pin_ ? static_cast<size_t>(pin_ - begin_) : 0;
+    size_t kept = static_cast<size_t>(end_ - from);
+
+    std::memmove(window_.data(), window_.data() + from_off, kept);
+    consumed_ += from_off;
+    if (kept == window_.size()) {
+        // A single token fills the whole window
+        window_.resize(window_.size() * 2);
+    }
+
+    size_t n = input_->read(window_.data() + kept, window_.size() - kept);
+
+    begin_ = window_.data();
+    end_ = begin_ + kept + n;
+    cur_ = begin_ + (cur_off - from_off);
+    keep = begin_ + (keep_off - from_off);
+    if (pin_) pin_ = begin_ + (pin_off - from_off);
+    return n > 0;
+}
+
+// Ensure at least `count` bytes are available at cur_
+bool JsonReader::available(size_t count, char*& keep) {
+    while (static_cast<size_t>(end_ - cur_) < count) {
+        if (!refill(keep)) return false;
+    }
+    return true;
+}
+
+bool JsonReader::fail(const char* message) {
+    if (error_.empty()) {
+        error_ = std::string(message) + " at offset " + std::to_string(offset());
+    }
+    return false;
+}
+
+void JsonReader::skip_whitespace() {
+    for (;;) {
+        while (cur_ < end_ && (*cur_ == ' ' || *cur_ == '\n' || *cur_ == '\r' || *cur_ == '\t')) {
+            cur_++;
+        }
+        if (cur_ < end_ || !refill(cur_)) return;
+    }
+}
+
+bool JsonReader::expect(char c) {
+    if (!ok()) return false;
+    skip_whitespace();
+    if (cur_ < end_ && *cur_ == c) {
+        cur_++;
+        return true;
+    }
+    return fail("Unexpected character");
+}
+
+bool JsonReader::expect_literal(const char* literal, size_t length) {
+    if (!available(length, cur_) || std::memcmp(cur_, literal, length) != 0) {
+        return fail("Invalid literal");
+    }
+    cur_ += length;
+    return true;
+}
+
+JsonReader::Type JsonReader::peek_type() {
+    if (!ok()) return Type::INVALID;
+    skip_whitespace();
+    if (cur_ >= end_) return Type::END;
+    switch (*cur_) {
+        case '"': return Type::STRING;
+        case '{': return Type::OBJECT;
+        case '[': return Type::ARRAY;
+        case 't':
+        case 'f': return Type::BOOL;
+        case 'n': return Type::NULL_VALUE;
+        default:
+            if (*cur_ == '-' || (*cur_ >= '0' && *cur_ <= '9')) return Type::NUMBER;
+            return Type::INVALID;
+    }
+}
+
+bool JsonReader::begin_object() {
+    if (!expect('{')) return false;
+    if (++depth_ > MAX_DEPTH) return fail("Nesting too deep");
+    first_item_ = true;
+    return true;
+}
+
+bool JsonReader::begin_array() {
+    if (!expect('[')) return false;
+    if (++depth_ > MAX_DEPTH) return fail("Nesting too deep");
+    first_item_ = true;
+    return true;
+}
+
+bool JsonReader::next_item(char close) {
+    if (!ok()) return false;
+    skip_whitespace();
+    if (cur_ < end_ && *cur_ == close) {
+        cur_++;
+        depth_--;
+        first_item_ = false;
+        return false;
+    }
+    if (!first_item_ && !expect(',')) return false;
+    first_item_ = false;
+    return true;
+}
+
+bool JsonReader::next_member(std::string_view& key) {
+    if (!next_item('}')) return false;
+    if (!read_string(key)) return false;
+
+    // Keep the key in the window while looking for the ':'
+    pin_ = const_cast<char*>(key.data());
+    bool result = expect(':');
+    key = std::string_view(pin_, key.size());
+    pin_ = nullptr;
+    return result;
+}
+
+bool JsonReader::next_element() {
+    return next_item(']');
+}
+
+bool JsonReader::parse_string_in_place(std::string_view& out) {
+    // cur_ points just past the opening quote
+    char* start = cur_;
+    char* write = nullptr; // Set once the first escape is seen
+
+    for (;;) {
+        if (!write) {
+            // Fast path: no escapes so far, the view points straight into the input
+            while (cur_ < end_ && *cur_ != '"' && *cur_ != '\\') cur_++;
+        } else {
+            while (cur_ < end_ && *cur_ != '"' && *cur_ != '\\') *write++ = *cur_++;
+        }
+        if (cur_ >= end_) {
+            size_t write_off = write ? static_cast<size_t>(write - start) : 0;
+            if (!refill(start)) return fail("Unterminated string");
+            if (write) write = start + write_off;
+            continue;
+        }
+        if (*cur_ == '"') break;
+
+        // Slow path: decode escapes in place. The decoded form is never longer
+        // than the escaped form, so the write cursor always trails the read cursor.
+        if (!write) write = cur_;
+        size_t write_off = static_cast<size_t>(write - start);
+        bool have_pair = available(12, start);
+        if (!have_pair && !available(2, start)) return fail("Unterminated escape sequence");
+        write = start + write_off;
+
+        char esc = cur_[1];
+        cur_ += 2;
+        switch (esc) {
+            case '"': *write++ = '"'; break;
+            case '\\': *write++ = '\\'; break;
+            case '/': *write++ = '/'; break;
+            case 'b': *write++ = '\b'; break;
+            case 'f': *write++ = '\f'; break;
+            case 'n': *write++ = '\n'; break;
+            case 'r': *write++ = '\r'; break;
+            case 't': *write++ = '\t'; break;
+            case 'u': {
+                unsigned cp;
+                if (end_ - cur_ < 4 || !read_hex4(cur_, cp)) return fail("Invalid unicode escape");
+                cur_ += 4;
+                // Combine UTF-16 surrogate pairs
+                if (cp >= 0xD800 && cp <= 0xDBFF && end_ - cur_ >= 6 &&
+                    cur_[0] == '\\' && cur_[1] == 'u') {
+                    unsigned low;
+                    if (read_hex4(cur_ + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        cur_ += 6;
+                    }
+                }
+                write += encode_utf8(cp, write);
+                break;
+            }
+            default:
+                return fail("Invalid escape sequence");
+        }
+    }
+
+    char* stop = write ? write : cur_;
+    out = std::string_view(start, static_cast<size_t>(stop - start));
+    cur_++; // Skip closing "
+    return true;
+}
+
+bool JsonReader::read_string(std::string_view& out) {
+    if (!expect('"')) return false;
+    return parse_string_in_place(out);
+}
+
+bool JsonReader::read_number(double& out) {
+    if (!ok()) return false;
+    skip_whitespace();
+
+    // Make sure the whole number is in the buffer before converting it
+    char* stop = cur_;
+    for (;;) {
+        while (stop < end_ && is_number_char(*stop)) stop++;
+        if (stop < end_) break;
+        size_t length = static_cast<size_t>(stop - cur_);
+        if (!refill(cur_)) break;
+        stop = cur_ + length;
+    }
+
+    auto result = std::from_chars(cur_, stop, out);
+    if (result.ec != std::errc()) return fail("Invalid number");
+    cur_ = const_cast<char*>(result.ptr);
+    return true;
+}
+
+bool JsonReader::read_bool(bool& out) {
+    if (!ok()) return false;
+    skip_whitespace();
+    if (cur_ < end_ && *cur_ == 't') {
+        out = true;
+        return expect_literal("true", 4);
+    }
+    out = false;
+    return expect_literal("false", 5);
+}
+
+bool JsonReader::read_null() {
+    if (!ok()) return false;
+    skip_whitespace();
+    return expect_literal("null", 4);
+}
+
+bool JsonReader::skip_value() {
+    std::string_view str;
+    double num;
+    bool flag;
+
+    switch (peek_type()) {
+        case Type::STRING: return read_string(str);
+        case Type::NUMBER: return read_number(num);
+        case Type::BOOL: return read_bool(flag);
+        case Type::NULL_VALUE: return read_null();
+        case Type::OBJECT: {
+            if (!begin_object()) return false;
+            std::string_view key;
+            while (next_member(key)) {
+                if (!skip_value()) return false;
+            }
+            return ok();
+        }
+        case Type::ARRAY: {
+            if (!begin_array()) return false;
+            while (next_element()) {
+                if (!skip_value()) return false;
+            }
+            return ok();
+        }
+        case Type::END: return fail("Unexpected end of input");
+        default: return fail("Unexpected character");
+    }
+}
+
+bool parse_events(JsonReader& reader, JsonHandler& handler) {
+    switch (reader.peek_type()) {
+        case JsonReader::Type::OBJECT: {
+            if (!reader.begin_object()) return false;
+            if (!handler.start_object()) return reader.fail("Rejected by handler");
+            std::string_view key;
+            while (reader.next_member(key)) {
+                if (!handler.key(key)) return reader.fail("Rejected by handler");
+                if (!parse_events(reader, handler)) return false;
+            }
+            if (!reader.ok()) return false;
+            return handler.end_object() || reader.fail("Rejected by handler");
+        }
+        case JsonReader::Type::ARRAY: {
+            if (!reader.begin_array()) return false;
+            if (!handler.start_array()) return reader.fail("Rejected by handler");
+            while (reader.next_element()) {
+                if (!parse_events(reader, handler)) return false;
+            }
+            if (!reader.ok()) return false;
+            return handler.end_array() || reader.fail("Rejected by handler");
+        }
+        case JsonReader::Type::STRING: {
+            std::string_view value;
+            if (!reader.read_string(value)) return false;
+            return handler.string(value) || reader.fail("Rejected by handler");
+        }
+        case JsonReader::Type::NUMBER: {
+            double value;
+            if (!reader.read_number(value)) return false;
+            return handler.number(value) || reader.fail("Rejected by handler");
+        }
+        case JsonReader::Type::BOOL: {
+            bool value;
+            if (!reader.read_bool(value)) return false;
+            return handler.boolean(value) || reader.fail("Rejected by handler");
+        }
+        case JsonReader::Type::NULL_VALUE:
+            if (!reader.read_null()) return false;
+            return handler.null() || reader.fail("Rejected by handler");
+        case JsonReader::Type::END:
+            return reader.fail("Unexpected end of input");
+        default:
+            return reader.fail("Unexpected character");
+    }
+}
+
+} // namespace AutoNestCut
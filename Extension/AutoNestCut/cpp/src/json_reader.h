@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Byte source for streaming input (stdin, pipes). read() returns the number
+// of bytes written to `dst`, or 0 at end of input.
+class JsonInput {
+public:
+    virtual ~JsonInput() = default;
+    virtual size_t read(char* dst, size_t max) = 0;
+};
+
+// Single-pass, in-situ JSON pull parser.
+//
+// Works directly on a mutable buffer: either a caller-owned contiguous buffer
+// (owned or memory-mapped) or an internal sliding window refilled from a
+// JsonInput. Strings are returned as string_views into that buffer; escape
+// sequences are decoded in place, so the buffer contents are modified while
+// parsing. Numbers are converted with std::from_chars. No DOM is built:
+// callers walk the document with begin_object()/next_member() and
+// begin_array()/next_element() and read the values they care about, or drive
+// a JsonHandler with parse_events().
+//
+// For a contiguous buffer, views stay valid for as long as the buffer lives.
+// In streaming mode they are only valid until the next call on the reader.
+//
+// Errors are sticky: after the first failure every call returns false and
+// error() describes the problem and its byte offset.
+class JsonReader {
+public:
+    enum class Type { END, NULL_VALUE, BOOL, NUMBER, STRING, ARRAY, OBJECT, INVALID };
+
+    // Deepest nesting of objects and arrays accepted; deeper input fails
+    // rather than recursing further in parse_events() and skip_value()
+    static constexpr int MAX_DEPTH = 256;
+
+    JsonReader(char* data, size_t size);
+    explicit JsonReader(JsonInput& input, size_t window_size = 64 * 1024);
+
+    // Type of the next value without consuming it
+    Type peek_type();
+
+    // Objects: begin_object() consumes '{', then next_member() yields each key
+    // and returns false once the closing '}' has been consumed.
+    bool begin_object();
+    bool next_member(std::string_view& key);
+
+    // Arrays: begin_array() consumes '[', then next_element() returns true
+    // before each element and false once the closing ']' has been consumed.
+    bool begin_array();
+    bool next_element();
+
+    bool read_string(std::string_view& out);
+    bool read_number(double& out);
+    bool read_bool(bool& out);
+    bool read_null();
+
+    // Skip the next value, including nested objects and arrays
+    bool skip_value();
+
+    // Report a caller-side error (e.g. a handler rejecting the document)
+    bool fail(const char* message);
+
+    bool ok() const { return error_.empty(); }
+    const std::string& error() const { return error_; }
+    size_t offset() const { return consumed_ + static_cast<size_t>(cur_ - begin_); }
+
+private:
+    char* begin_;
+    char* cur_;
+    char* end_;
+    bool first_item_ = false;
+    int depth_ = 0; // Objects and arrays open
+    std::string error_;
+
+    // Streaming state (unused for contiguous buffers)
+    JsonInput* input_ = nullptr;
+    std::vector<char> window_;
+    size_t consumed_ = 0;
+    char* pin_ = nullptr;
+
+    bool refill(char*& keep);
+    bool available(size_t count, char*& keep);
+    void skip_whitespace();
+    bool expect(char c);
+    bool expect_literal(const char* literal, size_t length);
+    bool parse_string_in_place(std::string_view& out);
+    bool next_item(char close);
+};
+
+// SAX-style event sink. Views passed to key() and string() are only valid for
+// the duration of the call. Returning false aborts parsing.
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+    virtual bool start_object() = 0;
+    virtual bool end_object() = 0;
+    virtual bool start_array() = 0;
+    virtual bool end_array() = 0;
+    virtual bool key(std::string_view key) = 0;
+    virtual bool string(std::string_view value) = 0;
+    virtual bool number(double value) = 0;
+    virtual bool boolean(bool value) = 0;
+    virtual bool null() = 0;
+};
+
+// Parse one value from `reader`, emitting events to `handler` as tokens arrive
+bool parse_events(JsonReader& reader, JsonHandler& handler);
+
+} // namespace AutoNestCut
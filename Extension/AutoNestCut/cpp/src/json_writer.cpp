@@ -0,0 +1,182 @@
+#include "json_writer.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace AutoNestCut {
+
+JsonWriter::JsonWriter(std::FILE* file, size_t flush_threshold)
+    : file_(file), flush_threshold_(flush_threshold) {
+    buffer_.reserve(flush_threshold_ + 4096);
+}
+
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+void JsonWriter::append(const char* data, size_t size) {
+    buffer_.insert(buffer_.end(), data, data + size);
+}
+
+void JsonWriter::append(char c) {
+    buffer_.push_back(c);
+}
+
+void JsonWriter::maybe_flush() {
+    if (buffer_.size() >= flush_threshold_) flush();
+}
+
+bool JsonWriter::flush() {
+    if (!buffer_.empty()) {
+        if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+            ok_ = false;
+        }
+        buffer_.clear();
+    }
+    return ok_;
+}
+
+void JsonWriter::newline_and_indent(size_t depth) {
+    static const char spaces[] = "                                ";
+    append('\n');
+    size_t width = depth * 2;
+    while (width > 0) {
+        size_t n = width < sizeof(spaces) - 1 ? width : sizeof(spaces) - 1;
+        append(spaces, n);
+        width -= n;
+    }
+}
+
+// Separator and indentation before a value (or before a key in an object)
+void JsonWriter::begin_value() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (stack_.empty()) return;
+    Level& level = stack_.back();
+    if (level.count++ > 0) append(',');
+    newline_and_indent(stack_.size());
+}
+
+JsonWriter& JsonWriter::begin_object() {
+    begin_value();
+    append('{');
+    stack_.push_back({true, 0});
+    return *this;
+}
+
+JsonWriter& JsonWriter::begin_array() {
+    begin_value();
+    append('[');
+    stack_.push_back({false, 0});
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_object() {
+    size_t count = stack_.back().count;
+    stack_.pop_back();
+    if (count > 0) newline_and_indent(stack_.size());
+    append('}');
+    if (stack_.empty()) append('\n');
+    maybe_flush();
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_array() {
+    size_t count = stack_.back().count;
+    stack_.pop_back();
+    if (count > 0) newline_and_indent(stack_.size());
+    append(']');
+    if (stack_.empty()) append('\n');
+    maybe_flush();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    begin_value();
+    escape(name);
+    append(": ", 2);
+    after_key_ = true;
+    return *this;
+}
+
+void JsonWriter::escape(std::string_view str) {
+    static const char hex[] = "0123456789abcdef";
+    append('"');
+    const char* run = str.data();
+    const char* end = str.data() + str.size();
+    for (const char* p = run; p < end; p++) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // Copy the unescaped run in one go, then the escape sequence
+        append(run, static_cast<size_t>(p - run));
+        run = p + 1;
+        switch (c) {
+            case '"': append("\\\"", 2); break;
+            case '\\': append("\\\\", 2); break;
+            case '\n': append("\\n", 2); break;
+            case '\r': append("\\r", 2); break;
+            case '\t': append("\\t", 2); break;
+            default: {
+                char seq[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                append(seq, sizeof(seq));
+            }
+        }
+    }
+    append(run, static_cast<size_t>(end - run));
+    append('"');
+}
+
+JsonWriter& JsonWriter::value(std::string_view str) {
+    begin_value();
+    escape(str);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    begin_value();
+    if (!std::isfinite(number)) {
+        append("null", 4);
+        return *this;
+    }
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    append(digits, static_cast<size_t>(result.ptr - digits));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(long long number) {
+    begin_value();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    append(digits, static_cast<size_t>(result.ptr - digits));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(unsigned long long number) {
+    begin_value();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    append(digits, static_cast<size_t>(result.ptr - digits));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    begin_value();
+    if (flag) {
+        append("true", 4);
+    } else {
+        append("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    begin_value();
+    append("null", 4);
+    return *this;
+}
+
+} // namespace AutoNestCut
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Buffered, pretty-printing JSON writer.
+//
+// Formats directly into a growable char buffer and hands it to the FILE* in
+// large blocks once it passes the flush threshold. Doubles use std::to_chars
+// (shortest round-trip form) and strings are escaped straight into the buffer,
+// so no temporaries are created per value. Commas, newlines and indentation
+// are inserted automatically from the begin/end calls.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::FILE* file, size_t flush_threshold = 1 << 20);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    JsonWriter& begin_object();
+    JsonWriter& end_object();
+    JsonWriter& begin_array();
+    JsonWriter& end_array();
+
+    // Member name inside an object; must be followed by exactly one value
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view str);
+    JsonWriter& value(const char* str) { return value(std::string_view(str)); }
+    JsonWriter& value(double number);
+    JsonWriter& value(int number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(long number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(long long number);
+    JsonWriter& value(unsigned number) { return value(static_cast<unsigned long long>(number)); }
+    JsonWriter& value(unsigned long number) { return value(static_cast<unsigned long long>(number)); }
+    JsonWriter& value(unsigned long long number);
+    JsonWriter& value(bool flag);
+    JsonWriter& null();
+
+    // Shorthand for key(name).value(v)
+    template <typename T>
+    JsonWriter& member(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+
+    // Write any buffered output; returns false if a write failed
+    bool flush();
+    bool ok() const { return ok_; }
+
+private:
+    struct Level {
+        bool is_object;
+        size_t count;
+    };
+
+    std::FILE* file_;
+    size_t flush_threshold_;
+    std::vector<char> buffer_;
+    std::vector<Level> stack_;
+    bool after_key_ = false;
+    bool ok_ = true;
+
+    void append(const char* data, size_t size);
+    void append(char c);
+    void newline_and_indent(size_t depth);
+    void begin_value();
+    void escape(std::string_view str);
+    void maybe_flush();
+};
+
+} // namespace AutoNestCut
@@ -1,359 +1,566 @@
+#include "binary_format.h"
+#include "input_source.h"
+#include "json_writer.h"
 #include "nesting.h"
+#include "request.h"
+#include "result_cache.h"
+#include "session.h"
+#include "trace.h"
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <chrono>
-#include <map>
-#include <algorithm>
-#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+using namespace AutoNestCut;
+
+void print_usage() {
+    std::cerr << "Usage: nester [options] <input.json|-> <output.json>\n"
+              << "Options:\n"
+              << "  --binary          Read a binary request and write a binary response\n"
+              << "  --binary-input    Read a binary request\n"
+              << "  --binary-output   Write a binary response\n"
+              << "  --cache-dir DIR   Reuse results of identical jobs cached in DIR\n"
+              << "  --cache-size N    Keep at most N cached results (default 64)\n"
+              << "  --session-dir DIR Save the result as a session in DIR; delta requests\n"
+              << "                    (with \"base_session\") are applied to sessions there\n"
+              << "  --profile         Add phase times and hot-path counters to stats\n"
+              << "  --perf-counters   Add hardware counters to the profile (Linux; implies --profile)\n"
+              << "  --alloc-stats     Add heap allocation counts to the profile (implies --profile)\n"
+              << "  --trace FILE      Write a Chrome trace-event timeline to FILE\n"
+              << "  --replay-log FILE Record every placement decision to FILE (see nester_replay)\n";
+}
 
-// Minimal JSON parser/writer (no external dependencies)
-namespace SimpleJSON {
-    
-std::string escape_string(const std::string& str) {
-    std::string result;
-    for (char c : str) {
-        switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default: result += c;
+// Hardware counts for one phase, with per-placement miss rates when it
+// placed parts; events the CPU does not count are left out
+void write_counters(JsonWriter& json, const PerfCounters& counters, const PerfSample& sample,
+                    size_t placements) {
+    json.begin_object()
+        .member("cycles", sample.cycles)
+        .member("instructions", sample.instructions)
+        .member("ipc", sample.ipc());
+    if (counters.has(PerfCounters::CACHE_MISSES)) {
+        json.member("cache_misses", sample.cache_misses);
+        if (placements > 0) {
+            json.member("cache_misses_per_placement",
+                        static_cast<double>(sample.cache_misses) / static_cast<double>(placements));
         }
     }
-    return result;
+    if (counters.has(PerfCounters::BRANCH_MISSES)) {
+        json.member("branch_misses", sample.branch_misses);
+        if (placements > 0) {
+            json.member("branch_misses_per_placement",
+                        static_cast<double>(sample.branch_misses) / static_cast<double>(placements));
+        }
+    }
+    json.end_object();
 }
 
-// Simple JSON value parser
-class Value {
-public:
-    enum Type { NULL_TYPE, BOOL, NUMBER, STRING, ARRAY, OBJECT };
-    
-    Type type = NULL_TYPE;
-    bool bool_val = false;
-    double num_val = 0;
-    std::string str_val;
-    std::vector<Value> array_val;
-    std::map<std::string, Value> object_val;
-    
-    bool is_null() const { return type == NULL_TYPE; }
-    bool is_bool() const { return type == BOOL; }
-    bool is_number() const { return type == NUMBER; }
-    bool is_string() const { return type == STRING; }
-    bool is_array() const { return type == ARRAY; }
-    bool is_object() const { return type == OBJECT; }
-    
-    bool as_bool() const { return bool_val; }
-    double as_number() const { return num_val; }
-    std::string as_string() const { return str_val; }
-    
-    const Value& operator[](const std::string& key) const {
-        static Value null_value;
-        auto it = object_val.find(key);
-        return it != object_val.end() ? it->second : null_value;
+// Heap activity for one phase, with allocations per placement when it
+// placed parts
+void write_allocs(JsonWriter& json, const AllocSample& sample, size_t placements) {
+    json.begin_object()
+        .member("allocations", sample.allocations)
+        .member("frees", sample.frees)
+        .member("bytes", sample.bytes);
+    if (placements > 0) {
+        json.member("allocations_per_placement",
+                    static_cast<double>(sample.allocations) / static_cast<double>(placements));
     }
-    
-    const Value& operator[](size_t index) const {
-        static Value null_value;
-        return index < array_val.size() ? array_val[index] : null_value;
+    json.end_object();
+}
+
+int main(int argc, char* argv[]) {
+    bool binary_input = false;
+    bool binary_output = false;
+    std::string cache_dir;
+    size_t cache_size = 64;
+    std::string session_dir;
+    bool profiling = false;
+    bool perf_counters = false;
+    bool alloc_stats = false;
+    std::string trace_file;
+    std::string replay_file;
+    std::vector<std::string> positional;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--binary") {
+            binary_input = true;
+            binary_output = true;
+        } else if (arg == "--binary-input") {
+            binary_input = true;
+        } else if (arg == "--binary-output") {
+            binary_output = true;
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (arg == "--cache-size" && i + 1 < argc) {
+            cache_size = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--session-dir" && i + 1 < argc) {
+            session_dir = argv[++i];
+        } else if (arg == "--profile") {
+            profiling = true;
+        } else if (arg == "--perf-counters") {
+            profiling = true;
+            perf_counters = true;
+        } else if (arg == "--alloc-stats") {
+            profiling = true;
+            alloc_stats = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (arg == "--replay-log" && i + 1 < argc) {
+            replay_file = argv[++i];
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            std::cerr << "ERROR: Unknown option: " << arg << std::endl;
+            print_usage();
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
     }
     
-    size_t size() const {
-        return is_array() ? array_val.size() : 
-               is_object() ? object_val.size() : 0;
+    if (positional.size() != 2) {
+        print_usage();
+        return 1;
     }
-};
-
-// Simple recursive descent parser
-class Parser {
-    std::string json;
-    size_t pos = 0;
     
-    void skip_whitespace() {
-        while (pos < json.size() && std::isspace(json[pos])) pos++;
+    std::string input_file = positional[0];
+    std::string output_file = positional[1];
+    
+#if !AUTONESTCUT_PROFILE
+    if (profiling || !trace_file.empty() || !replay_file.empty()) {
+        std::cerr << "WARNING: Built without profiling support; --profile, --perf-counters, --alloc-stats, "
+                  << "--trace and --replay-log are ignored" << std::endl;
+        profiling = false;
+        perf_counters = false;
+        alloc_stats = false;
+        trace_file.clear();
+        replay_file.clear();
     }
-    
-    char peek() {
-        skip_whitespace();
-        return pos < json.size() ? json[pos] : '\0';
+#endif
+    Profile profile;
+    Profile* prof = profiling ? &profile : nullptr;
+    
+    PerfCounters counters;
+    if (perf_counters) {
+        std::string counters_error;
+        if (counters.open(counters_error)) {
+            profile.counters = &counters;
+        } else {
+            std::cerr << "WARNING: Hardware counters unavailable (" << counters_error << ")" << std::endl;
+        }
     }
-    
-    char consume() {
-        skip_whitespace();
-        return pos < json.size() ? json[pos++] : '\0';
+    if (alloc_stats) {
+        profile.alloc_tracking = enable_alloc_tracking();
     }
     
-    bool match(char c) {
-        if (peek() == c) {
-            consume();
-            return true;
+    Trace trace;
+    Trace* tracer = nullptr;
+    if (!trace_file.empty()) {
+        std::string trace_error;
+        if (!trace.open(trace_file, trace_error)) {
+            std::cerr << "ERROR: " << trace_error << std::endl;
+            return 1;
         }
-        return false;
+        trace.name_thread("main");
+        tracer = &trace;
     }
     
-    std::string parse_string() {
-        if (consume() != '"') return "";
-        std::string result;
-        while (pos < json.size() && json[pos] != '"') {
-            if (json[pos] == '\\' && pos + 1 < json.size()) {
-                pos++;
-                switch (json[pos]) {
-                    case 'n': result += '\n'; break;
-                    case 'r': result += '\r'; break;
-                    case 't': result += '\t'; break;
-                    default: result += json[pos];
-                }
-            } else {
-                result += json[pos];
-            }
-            pos++;
+    ReplayLog replay;
+    if (!replay_file.empty()) {
+        std::string replay_error;
+        if (!replay.open(replay_file, replay_error)) {
+            std::cerr << "ERROR: " << replay_error << std::endl;
+            return 1;
         }
-        if (pos < json.size()) pos++; // Skip closing "
-        return result;
     }
     
-    double parse_number() {
-        size_t start = pos;
-        if (json[pos] == '-') pos++;
-        while (pos < json.size() && (std::isdigit(json[pos]) || json[pos] == '.')) pos++;
-        return std::stod(json.substr(start, pos - start));
-    }
+    auto start_time = std::chrono::high_resolution_clock::now();
     
-    Value parse_value() {
-        Value val;
-        char c = peek();
-        
-        if (c == '"') {
-            val.type = Value::STRING;
-            val.str_val = parse_string();
-        } else if (c == '{') {
-            val.type = Value::OBJECT;
-            consume(); // {
-            while (peek() != '}') {
-                std::string key = parse_string();
-                if (!match(':')) break;
-                val.object_val[key] = parse_value();
-                if (!match(',')) break;
-            }
-            match('}');
-        } else if (c == '[') {
-            val.type = Value::ARRAY;
-            consume(); // [
-            while (peek() != ']') {
-                val.array_val.push_back(parse_value());
-                if (!match(',')) break;
+    NestRequest request;
+    std::string parse_error;
+    bool parsed;
+    
+    if (input_file == "-") {
+        // Stream from stdin: a background thread reads ahead while the
+        // parser appends parts to their material pools
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        PrefetchReader stdin_reader(stdin);
+        NEST_PROFILE_SCOPE(prof, prof->parse_ms); // Reading overlaps parsing
+        NEST_PERF_SCOPE(prof, prof->parse_counters);
+        NEST_ALLOC_SCOPE(prof, prof->parse_allocs);
+        NEST_TRACE_SPAN(parse_span, tracer, "read and parse", "phase");
+        if (binary_input) {
+            std::vector<char> bytes;
+            char block[64 * 1024];
+            size_t n;
+            while ((n = stdin_reader.read(block, sizeof(block))) > 0) {
+                bytes.insert(bytes.end(), block, block + n);
             }
-            match(']');
-        } else if (c == 't' || c == 'f') {
-            val.type = Value::BOOL;
-            val.bool_val = (c == 't');
-            pos += (c == 't' ? 4 : 5); // Skip "true" or "false"
-        } else if (c == 'n') {
-            val.type = Value::NULL_TYPE;
-            pos += 4; // Skip "null"
-        } else if (c == '-' || std::isdigit(c)) {
-            val.type = Value::NUMBER;
-            val.num_val = parse_number();
+            parsed = read_binary_request(bytes.data(), bytes.size(), request, parse_error);
+        } else {
+            parsed = parse_request(stdin_reader, request, parse_error);
+        }
+    } else {
+        // Map the input file; the parser works on the mapped bytes in place
+        MappedFile input;
+        std::string open_error;
+        bool opened;
+        {
+            NEST_PROFILE_SCOPE(prof, prof->read_ms);
+            NEST_TRACE_SPAN(read_span, tracer, "read", "phase");
+            opened = input.open(input_file, open_error);
+        }
+        if (!opened) {
+            std::cerr << "ERROR: " << open_error << std::endl;
+            return 1;
         }
         
-        return val;
+        NEST_PROFILE_SCOPE(prof, prof->parse_ms);
+        NEST_PERF_SCOPE(prof, prof->parse_counters);
+        NEST_ALLOC_SCOPE(prof, prof->parse_allocs);
+        NEST_TRACE_SPAN(parse_span, tracer, "parse", "phase");
+        if (binary_input) {
+            parsed = read_binary_request(input.data(), input.size(), request, parse_error);
+        } else {
+            parsed = parse_request(input.data(), input.size(), request, parse_error);
+        }
     }
     
-public:
-    Value parse(const std::string& json_str) {
-        json = json_str;
-        pos = 0;
-        return parse_value();
-    }
-};
-
-} // namespace SimpleJSON
-
-using namespace AutoNestCut;
-
-// Parse grain direction to allowed rotations
-std::vector<int> parse_grain_direction(const std::string& grain) {
-    std::string lower = grain;
-    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-    
-    if (lower == "fixed" || lower == "vertical" || lower == "horizontal") {
-        return {0}; // No rotation
-    }
-    return {0, 90}; // Allow 90-degree rotation for "any"
-}
-
-int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: nester <input.json> <output.json>" << std::endl;
+    if (!parsed) {
+        std::cerr << "ERROR: " << parse_error << std::endl;
         return 1;
     }
     
-    std::string input_file = argv[1];
-    std::string output_file = argv[2];
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    // Read input JSON
-    std::ifstream input(input_file);
-    if (!input.is_open()) {
-        std::cerr << "ERROR: Cannot open input file: " << input_file << std::endl;
-        return 1;
+    // A delta request edits a saved session: the request read above only
+    // holds the changes, and `request` becomes the merged job
+    bool delta_mode = !request.base_session.empty();
+    NestRequest delta;
+    NestRequest base;
+    Solution base_solution;
+    
+    if (delta_mode) {
+        if (session_dir.empty()) {
+            std::cerr << "ERROR: Delta request needs --session-dir" << std::endl;
+            return 1;
+        }
+        std::string session_error;
+        if (!load_session(session_dir, request.base_session, base, base_solution, session_error)) {
+            std::cerr << "ERROR: " << session_error << std::endl;
+            return 1;
+        }
+        // The merged job has at most the materials and grains of both
+        if (base.materials.size() + request.materials.size() > MAX_MATERIALS) {
+            std::cerr << "ERROR: Too many materials (max " << MAX_MATERIALS << ")" << std::endl;
+            return 1;
+        }
+        if (base.grains.size() + request.grains.size() > MAX_GRAINS) {
+            std::cerr << "ERROR: Too many grain directions (max " << MAX_GRAINS << ")" << std::endl;
+            return 1;
+        }
+        delta = std::move(request);
+        request = NestRequest();
+        request.settings = base.settings;
+        
+        std::cout << "Delta against session " << delta.base_session << ": "
+                  << delta.part_count << " added or modified, "
+                  << delta.removed_part_ids.size() << " removed" << std::endl;
     }
     
-    std::stringstream buffer;
-    buffer << input.rdbuf();
-    std::string json_str = buffer.str();
-    input.close();
+    const Settings& settings = request.settings;
     
-    // Parse JSON
-    SimpleJSON::Parser parser;
-    auto root = parser.parse(json_str);
+    std::cout << "Settings: kerf=" << settings.kerf_width 
+              << "mm, allow_rotation=" << settings.allow_rotation << std::endl;
     
-    if (!root.is_object()) {
-        std::cerr << "ERROR: Invalid JSON format" << std::endl;
-        return 1;
-    }
+    Nester nester(settings, &request.materials, &request.part_ids);
+    nester.set_profile(prof);
+    nester.set_trace(tracer);
+    nester.set_replay(replay_file.empty() ? nullptr : &replay);
+    Solution result;
+    DeltaStats delta_stats;
     
-    // Parse settings
-    Settings settings;
-    auto settings_obj = root["settings"];
-    if (settings_obj.is_object()) {
-        if (settings_obj["kerf"].is_number()) {
-            settings.kerf_width = settings_obj["kerf"].as_number();
-        }
-        if (settings_obj["allow_rotation"].is_bool()) {
-            settings.allow_rotation = settings_obj["allow_rotation"].as_bool();
-        }
+    if (delta_mode) {
+        NEST_TRACE_SPAN(delta_span, tracer, "apply delta", "phase");
+        apply_delta(base, base_solution, delta, nester, request, result, delta_stats);
     }
     
-    std::cout << "Settings: kerf=" << settings.kerf_width 
-              << "mm, allow_rotation=" << settings.allow_rotation << std::endl;
+    std::vector<MaterialId> material_order;
+    {
+        NEST_PROFILE_SCOPE(prof, prof->order_ms);
+        NEST_TRACE_SPAN(order_span, tracer, "order materials", "phase");
+        material_order = request.materials_by_name();
+    }
     
-    // Parse boards
-    std::map<std::string, std::pair<double, double>> board_sizes;
-    auto boards_array = root["boards"];
-    if (boards_array.is_array()) {
-        for (size_t i = 0; i < boards_array.size(); i++) {
-            auto board = boards_array[i];
-            std::string material = board["material"].as_string();
-            double width = board["width"].as_number();
-            double height = board["height"].as_number();
-            board_sizes[material] = {width, height};
+    std::cout << "Loaded " << request.part_count << " parts across " 
+              << material_order.size() << " materials" << std::endl;
+    
+    // Identical jobs (same geometry and settings) reuse a cached layout,
+    // except when the decisions are being recorded
+    ResultCache cache(cache_dir, cache_size);
+    uint64_t hash = 0;
+    int cache_hits = 0;
+    int cache_misses = 0;
+    
+    if (!cache_dir.empty() && !delta_mode) {
+        NEST_TRACE_SPAN(cache_span, tracer, "cache lookup", "phase");
+        hash = job_hash(request, material_order);
+        if (replay_file.empty() && cache.load(hash, request, material_order, result)) {
+            cache_hits++;
+            std::cout << "Cache hit: " << hash_to_hex(hash) << std::endl;
+        } else {
+            cache_misses++;
         }
     }
     
-    // Parse parts and group by material
-    std::map<std::string, std::vector<Part>> parts_by_material;
-    auto parts_array = root["parts"];
-    if (parts_array.is_array()) {
-        for (size_t i = 0; i < parts_array.size(); i++) {
-            auto part_obj = parts_array[i];
-            
-            Part part;
-            part.id = part_obj["id"].as_string();
-            part.material = part_obj["material"].as_string();
-            part.width = part_obj["width"].as_number();
-            part.height = part_obj["height"].as_number();
-            
-            std::string grain = part_obj["grain_direction"].as_string();
-            if (grain.empty()) grain = "any";
-            part.grain_direction = grain;
+    // Run nesting for each material
+    if (cache_hits == 0 && !delta_mode) {
+        // nest_parts appends to these once per material; sizing them here
+        // keeps that from reallocating
+        result.placements.reserve(request.part_count);
+        result.boards.reserve(request.min_boards());
+        
+        NEST_TRACE_SPAN(nest_span, tracer, "nest", "phase");
+        for (MaterialId material : material_order) {
+            std::cout << "\n=== Processing material: " << request.materials.get(material) << " ===" << std::endl;
             
-            if (settings.allow_rotation) {
-                part.allowed_rotations = parse_grain_direction(grain);
-            } else {
-                part.allowed_rotations = {0};
+            const BoardSize& board_size = request.board_sizes[material];
+            nester.nest_parts(request.parts_by_material[material], material,
+                              board_size.width, board_size.height, result);
+        }
+        
+        if (!cache_dir.empty()) {
+            NEST_TRACE_SPAN(store_span, tracer, "cache store", "phase");
+            std::string cache_error;
+            if (!cache.store(hash, request, material_order, result, cache_error)) {
+                std::cerr << "WARNING: " << cache_error << std::endl;
             }
-            
-            parts_by_material[part.material].push_back(part);
         }
     }
     
-    std::cout << "Loaded " << parts_array.size() << " parts across " 
-              << parts_by_material.size() << " materials" << std::endl;
-    
-    // Run nesting for each material
-    Nester nester(settings);
-    std::vector<Board> all_boards;
+    if (!replay_file.empty()) {
+        uint16_t flags = delta_mode ? Replay::DELTA : 0;
+        if (!replay.close(job_hash(request, material_order), flags)) {
+            std::cerr << "WARNING: Failed to write replay log: " << replay_file << std::endl;
+        }
+    }
     
-    for (auto& [material, parts] : parts_by_material) {
-        std::cout << "\n=== Processing material: " << material << " ===" << std::endl;
-        
-        auto board_size_it = board_sizes.find(material);
-        double board_width = 2440.0;
-        double board_height = 1220.0;
-        
-        if (board_size_it != board_sizes.end()) {
-            board_width = board_size_it->second.first;
-            board_height = board_size_it->second.second;
+    std::string new_session;
+    if (!session_dir.empty()) {
+        NEST_TRACE_SPAN(session_span, tracer, "save session", "phase");
+        std::string session_error;
+        new_session = session_id(request, material_order);
+        if (!save_session(session_dir, new_session, request, result, session_error)) {
+            std::cerr << "WARNING: " << session_error << std::endl;
+            new_session.clear();
         }
-        
-        auto boards = nester.nest_parts(parts, material, board_width, board_height);
-        all_boards.insert(all_boards.end(), boards.begin(), boards.end());
     }
     
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
     
     std::cout << "\n=== Nesting Complete ===" << std::endl;
-    std::cout << "Total boards: " << all_boards.size() << std::endl;
+    std::cout << "Total boards: " << result.boards.size() << std::endl;
     std::cout << "Time: " << duration.count() << "ms" << std::endl;
     
+    if (binary_output) {
+        // The binary response has no stats block; report the profile here
+        if (prof) {
+            std::cout << "Profile: read " << prof->read_ms << "ms, parse " << prof->parse_ms
+                      << "ms, order " << prof->order_ms << "ms, group " << prof->group_ms << "ms, sort " << prof->sort_ms
+                      << "ms, nest " << prof->nest_ms() << "ms, "
+                      << prof->find_position_calls << " searches over "
+                      << prof->free_rects_avg() << " free rects on average (max "
+                      << prof->free_rects_max << "), " << prof->add_part_calls << " placements" << std::endl;
+            if (prof->counters) {
+                PerfSample nest = prof->nest_counters();
+                size_t placements = std::max<size_t>(prof->placements(), 1);
+                std::cout << "Counters: nest IPC " << nest.ipc() << ", "
+                          << static_cast<double>(nest.cache_misses) / placements << " cache misses and "
+                          << static_cast<double>(nest.branch_misses) / placements
+                          << " branch misses per placement" << std::endl;
+            }
+            if (prof->alloc_tracking) {
+                AllocSample total = alloc_snapshot();
+                AllocSample nest = prof->nest_allocs();
+                std::cout << "Allocations: " << total.allocations << " (" << total.bytes << " bytes), parse "
+                          << prof->parse_allocs.allocations << ", nest " << nest.allocations
+                          << ", peak live " << alloc_peak_live_bytes() << " bytes" << std::endl;
+            }
+        }
+        std::string write_error;
+        bool binary_written;
+        {
+            NEST_TRACE_SPAN(write_span, tracer, "write", "phase");
+            binary_written = write_binary_response(output_file, result, request, duration.count(), write_error);
+        }
+        if (!binary_written) {
+            std::cerr << "ERROR: " << write_error << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to: " << output_file << std::endl;
+        if (tracer && !trace.close()) {
+            std::cerr << "WARNING: Failed to write trace file: " << trace_file << std::endl;
+        }
+        return 0;
+    }
+    
     // Write output JSON
-    std::ofstream output(output_file);
-    if (!output.is_open()) {
+    std::FILE* output = std::fopen(output_file.c_str(), "wb");
+    if (!output) {
         std::cerr << "ERROR: Cannot open output file: " << output_file << std::endl;
         return 1;
     }
     
-    output << "{\n";
-    output << "  \"placements\": [\n";
-    
-    bool first_placement = true;
-    for (const auto& board : all_boards) {
-        for (const auto* part : board.placed_parts) {
-            if (!first_placement) output << ",\n";
-            first_placement = false;
+    bool written;
+    {
+        JsonWriter json(output);
+        json.begin_object();
+        
+        {
+            NEST_PROFILE_SCOPE(prof, prof->write_ms);
+            NEST_PERF_SCOPE(prof, prof->write_counters);
+            NEST_ALLOC_SCOPE(prof, prof->write_allocs);
+            NEST_TRACE_SPAN(write_span, tracer, "write", "phase");
+            json.key("placements").begin_array();
+            for (const auto& placement : result.placements) {
+                const PartStore& parts = request.parts_by_material[placement.material];
+                json.begin_object()
+                    .member("part_id", request.part_ids.get(parts.id[placement.part]))
+                    .member("board_id", placement.board_id)
+                    .member("x", placement.x)
+                    .member("y", placement.y)
+                    .member("rotation", placement.rotation)
+                    .end_object();
+            }
+            json.end_array();
+        
+            json.key("boards").begin_array();
+            for (const auto& board : result.boards) {
+                json.begin_object()
+                    .member("id", board.id)
+                    .member("material", request.materials.get(board.material))
+                    .member("width", board.width)
+                    .member("height", board.height)
+                    .member("parts_count", board.placement_count)
+                    .member("used_area", board.used_area())
+                    .member("waste_percentage", board.waste_percentage());
             
-            output << "    {\n";
-            output << "      \"part_id\": \"" << SimpleJSON::escape_string(part->id) << "\",\n";
-            output << "      \"board_id\": " << part->board_id << ",\n";
-            output << "      \"x\": " << part->x << ",\n";
-            output << "      \"y\": " << part->y << ",\n";
-            output << "      \"rotation\": " << part->rotation << "\n";
-            output << "    }";
+                json.key("offcuts").begin_array();
+                for (uint32_t i = 0; i < board.offcut_count; i++) {
+                    const Rect& offcut = result.offcuts[board.first_offcut + i];
+                    json.begin_object()
+                        .member("x", offcut.x)
+                        .member("y", offcut.y)
+                        .member("width", offcut.width)
+                        .member("height", offcut.height)
+                        .end_object();
+                }
+                json.end_array();
+                json.end_object();
+            }
+            json.end_array();
         }
-    }
-    
-    output << "\n  ],\n";
-    output << "  \"boards\": [\n";
-    
-    for (size_t i = 0; i < all_boards.size(); i++) {
-        const auto& board = all_boards[i];
-        if (i > 0) output << ",\n";
         
-        output << "    {\n";
-        output << "      \"id\": " << board.id << ",\n";
-        output << "      \"material\": \"" << SimpleJSON::escape_string(board.material) << "\",\n";
-        output << "      \"width\": " << board.width << ",\n";
-        output << "      \"height\": " << board.height << ",\n";
-        output << "      \"parts_count\": " << board.placed_parts.size() << ",\n";
-        output << "      \"used_area\": " << board.used_area() << ",\n";
-        output << "      \"waste_percentage\": " << board.waste_percentage() << "\n";
-        output << "    }";
+        const NestStats& nest_stats = nester.stats();
+        json.key("stats").begin_object()
+            .member("time_ms", static_cast<long long>(duration.count()))
+            .member("boards_used", result.boards.size())
+            .member("fit_checks", nest_stats.fit_checks)
+            .member("fit_checks_skipped", nest_stats.fit_checks_skipped)
+            .member("parts_skipped", nest_stats.parts_skipped)
+            .member("boards_closed_early", nest_stats.boards_closed_early)
+            .member("parts_skipped_by_close", nest_stats.parts_skipped_by_close)
+            .member("close_time_saved_ms", nest_stats.close_time_saved_ms())
+            .member("free_rects_peak", nest_stats.free_rects_peak)
+            .member("cache_hits", cache_hits)
+            .member("cache_misses", cache_misses);
+        if (!cache_dir.empty() && !delta_mode) json.member("job_hash", hash_to_hex(hash));
+        if (!new_session.empty()) json.member("session_id", new_session);
+        if (delta_mode) {
+            json.member("base_session", delta.base_session)
+                .member("boards_kept", delta_stats.boards_kept)
+                .member("boards_repacked", delta_stats.boards_repacked)
+                .member("parts_repacked", delta_stats.parts_repacked);
+        }
+        if (prof) {
+            json.key("profile").begin_object()
+                .member("read_ms", prof->read_ms)
+                .member("parse_ms", prof->parse_ms)
+                .member("order_ms", prof->order_ms)
+                .member("group_ms", prof->group_ms)
+                .member("sort_ms", prof->sort_ms)
+                .member("nest_ms", prof->nest_ms())
+                .member("write_ms", prof->write_ms)
+                .member("find_best_position_calls", prof->find_position_calls)
+                .member("add_part_calls", prof->add_part_calls)
+                .member("free_rects_max", prof->free_rects_max)
+                .member("free_rects_avg", prof->free_rects_avg());
+            if (prof->counters) {
+                json.key("counters").begin_object();
+                json.key("parse");
+                write_counters(json, *prof->counters, prof->parse_counters, 0);
+                json.key("nest");
+                write_counters(json, *prof->counters, prof->nest_counters(), prof->placements());
+                json.key("write");
+                write_counters(json, *prof->counters, prof->write_counters, 0);
+                json.end_object();
+            }
+            if (prof->alloc_tracking) {
+                json.key("allocations").begin_object();
+                json.key("parse");
+                write_allocs(json, prof->parse_allocs, 0);
+                json.key("nest");
+                write_allocs(json, prof->nest_allocs(), prof->placements());
+                json.key("write");
+                write_allocs(json, prof->write_allocs, 0);
+                json.key("total");
+                write_allocs(json, alloc_snapshot(), 0);
+                json.member("peak_live_bytes", alloc_peak_live_bytes());
+                json.end_object();
+            }
+            json.key("materials").begin_array();
+            for (const auto& m : prof->materials) {
+                json.begin_object()
+                    .member("material", request.materials.get(m.material))
+                    .member("parts", m.parts)
+                    .member("placements", m.placements)
+                    .member("nest_ms", m.ms);
+                if (prof->counters) {
+                    json.key("counters");
+                    write_counters(json, *prof->counters, m.counters, m.placements);
+                }
+                if (prof->alloc_tracking) {
+                    json.key("allocations");
+                    write_allocs(json, m.allocs, m.placements);
+                }
+                json.end_object();
+            }
+            json.end_array();
+            json.end_object();
+        }
+        json.end_object();
+        
+        json.end_object();
+        written = json.flush();
     }
     
-    output << "\n  ],\n";
-    output << "  \"stats\": {\n";
-    output << "    \"time_ms\": " << duration.count() << ",\n";
-    output << "    \"boards_used\": " << all_boards.size() << "\n";
-    output << "  }\n";
-    output << "}\n";
-    
-    output.close();
+    if (std::fclose(output) != 0 || !written) {
+        std::cerr << "ERROR: Failed to write output file: " << output_file << std::endl;
+        return 1;
+    }
     
     std::cout << "Results written to: " << output_file << std::endl;
     
+    if (tracer && !trace.close()) {
+        std::cerr << "WARNING: Failed to write trace file: " << trace_file << std::endl;
+    }
+    
     return 0;
 }
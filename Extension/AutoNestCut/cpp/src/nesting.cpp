@@ -1,62 +1,145 @@
 #include "nesting.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <unordered_map>
 
 namespace AutoNestCut {
 
-Nester::Nester(const Settings& settings) : settings_(settings) {}
+namespace {
 
-bool Board::find_best_position(double part_width, double part_height, 
-                               double kerf, double& out_x, double& out_y) {
-    // Special case: exact fit on empty board (no kerf needed)
-    if (placed_parts.empty() && 
+// Parts with the same dimensions and rotation mask behave identically in
+// the placement loop
+struct Shape {
+    double width;
+    double height;
+    RotationMask rotations;
+    
+    bool operator==(const Shape& other) const {
+        return width == other.width && height == other.height && rotations == other.rotations;
+    }
+};
+
+struct ShapeHash {
+    size_t operator()(const Shape& shape) const {
+        uint64_t w, h;
+        std::memcpy(&w, &shape.width, sizeof(w));
+        std::memcpy(&h, &shape.height, sizeof(h));
+        uint64_t hash = w * 0x9E3779B97F4A7C15ull;
+        hash ^= h + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+        return static_cast<size_t>(hash ^ shape.rotations);
+    }
+};
+
+} // namespace
+
+Nester::Nester(const Settings& settings,
+               const StringTable* materials,
+               const StringTable* part_ids)
+    : settings_(settings), materials_(materials), part_ids_(part_ids),
+      arena_(64 * 1024) {}
+
+std::string Nester::material_name(MaterialId material) const {
+    if (materials_) return std::string(materials_->get(material));
+    return "#" + std::to_string(material);
+}
+
+std::string Nester::part_name(const PartStore& parts, uint32_t part) const {
+    if (part_ids_) return std::string(part_ids_->get(parts.id[part]));
+    return "#" + std::to_string(parts.id[part]);
+}
+
+void Board::reset(int id_, uint32_t first) {
+    id = id_;
+    first_placement = first;
+    placed_count = 0;
+    placed_area = 0;
+    free_rectangles.clear();
+    free_rectangles.emplace_back(0, 0, width, height);
+    update_free_bounds();
+}
+
+void Board::update_free_bounds() {
+    max_free_width = 0;
+    max_free_height = 0;
+    max_free_area = 0;
+    for (const auto& rect : free_rectangles) {
+        max_free_width = std::max(max_free_width, rect.width);
+        max_free_height = std::max(max_free_height, rect.height);
+        max_free_area = std::max(max_free_area, rect.width * rect.height);
+    }
+}
+
+size_t Board::best_rect(double part_width, double part_height, double kerf) const {
+    // Special case: exact fit on empty board (no kerf needed); the only free
+    // rectangle is then the whole board
+    if (placed_count == 0 && 
         std::abs(part_width - width) < 0.1 && 
         std::abs(part_height - height) < 0.1) {
-        out_x = 0;
-        out_y = 0;
-        return true;
+        return 0;
     }
     
     double effective_width = part_width + kerf;
     double effective_height = part_height + kerf;
     
     // Try each free rectangle (already sorted by Y then X for bottom-left preference)
-    for (const auto& rect : free_rectangles) {
+    for (size_t i = 0; i < free_rectangles.size(); i++) {
+        const Rect& rect = free_rectangles[i];
         if (effective_width <= rect.width && effective_height <= rect.height) {
             // Check board boundaries
             if (rect.x + effective_width <= width && 
                 rect.y + effective_height <= height) {
-                out_x = rect.x;
-                out_y = rect.y;
-                return true;
+                return i;
             }
         }
     }
     
-    return false;
+    return free_rectangles.size();
 }
 
-void Board::add_part(Part* part, double x, double y, double kerf) {
-    part->x = x;
-    part->y = y;
-    part->board_id = id;
-    placed_parts.push_back(part);
+bool Board::find_best_position(double part_width, double part_height, 
+                               double kerf, double& out_x, double& out_y) {
+    size_t rect = best_rect(part_width, part_height, kerf);
+    if (rect == free_rectangles.size()) return false;
+    out_x = free_rectangles[rect].x;
+    out_y = free_rectangles[rect].y;
+    return true;
+}
+
+void Board::add_part(const PartStore& parts, uint32_t part, int rotation,
+                     double x, double y, double kerf, std::vector<Placement>& placements) {
+    Placement placement{};
+    placement.x = x;
+    placement.y = y;
+    placement.part = part;
+    placement.board_id = id;
+    placement.rotation = rotation;
+    placement.material = material;
+    placements.push_back(placement);
+    placed_count++;
+    placed_area += parts.area(part);
     
     // Rectangle occupied by part + kerf
     double w, h;
-    part->get_rotated_dimensions(part->rotation, w, h);
+    parts.get_rotated_dimensions(part, rotation, w, h);
     Rect placed_rect(x, y, w + kerf, h + kerf);
     
-    // Update free rectangles
-    std::vector<Rect> updated_free_rects;
+    // Update free rectangles. The new list is built in the scratch buffer and
+    // swapped in, so both buffers keep their capacity across placements and
+    // the arena is not asked for a fresh vector every time.
+    std::pmr::vector<Rect>& updated_free_rects = scratch_rectangles;
+    updated_free_rects.clear();
     
     for (const auto& free_rect : free_rectangles) {
         if (intersects(free_rect, placed_rect)) {
             // Subtract placed rectangle from free rectangle
-            auto new_rects = subtract_rect(free_rect, placed_rect);
-            for (const auto& r : new_rects) {
-                if (r.is_valid()) {
-                    updated_free_rects.push_back(r);
+            Rect new_rects[4];
+            int count = subtract_rect(free_rect, placed_rect, new_rects);
+            for (int i = 0; i < count; i++) {
+                if (new_rects[i].is_valid()) {
+                    updated_free_rects.push_back(new_rects[i]);
                 }
             }
         } else {
@@ -65,7 +148,8 @@ void Board::add_part(Part* part, double x, double y, double kerf) {
         }
     }
     
-    free_rectangles = std::move(updated_free_rects);
+    free_rectangles.swap(updated_free_rects);
+    update_free_bounds();
     
     // Sort by Y then X for bottom-left preference
     std::sort(free_rectangles.begin(), free_rectangles.end(),
@@ -77,65 +161,143 @@ void Board::add_part(Part* part, double x, double y, double kerf) {
         });
 }
 
-double Board::used_area() const {
-    double total = 0;
-    for (const auto* part : placed_parts) {
-        total += part->area();
+size_t Board::first_unfit(const FitBound* bounds, size_t from, size_t to) const {
+    // Usually even the last bound still fits and nothing changes
+    if (from >= to || may_fit_any(bounds[to - 1])) return to;
+    return std::partition_point(bounds + from, bounds + to - 1,
+        [this](const FitBound& bound) { return may_fit_any(bound); }) - bounds;
+}
+
+BoardRecord Board::finish(double min_offcut, std::vector<Rect>& offcuts) {
+    BoardRecord board{};
+    board.width = width;
+    board.height = height;
+    board.placed_area = placed_area;
+    board.id = id;
+    board.material = material;
+    board.first_placement = first_placement;
+    board.placement_count = placed_count;
+    board.first_offcut = static_cast<uint32_t>(offcuts.size());
+    
+    // Free rectangles never overlap, so they can be reported as they are
+    for (const auto& rect : free_rectangles) {
+        if (rect.width >= min_offcut && rect.height >= min_offcut) {
+            offcuts.push_back(rect);
+        }
+    }
+    board.offcut_count = static_cast<uint32_t>(offcuts.size()) - board.first_offcut;
+    
+    free_rectangles.clear();
+    scratch_rectangles.clear();
+    update_free_bounds();
+    return board;
+}
+
+bool Nester::find_position(const Board& board, double w, double h, size_t& rect) {
+    if (!board.may_fit(w, h, settings_.kerf_width)) {
+        stats_.fit_checks_skipped++;
+        return false;
     }
-    return total;
+    stats_.fit_checks++;
+    NEST_PROFILE(profile_, {
+        uint64_t length = board.free_rectangles.size();
+        profile_->find_position_calls++;
+        profile_->free_rects_scanned += length;
+        profile_->free_rects_max = std::max(profile_->free_rects_max, length);
+    });
+    rect = board.best_rect(w, h, settings_.kerf_width);
+    return rect < board.free_rectangles.size();
 }
 
-double Board::waste_percentage() const {
-    double total = width * height;
-    if (total == 0) return 0;
-    return ((total - used_area()) / total) * 100.0;
+void Nester::record_decision(const Board& board, uint32_t part, int rotation, size_t rect) {
+    Replay::Record record{};
+    record.part = part;
+    record.board_id = board.id;
+    record.rect_index = static_cast<uint32_t>(rect);
+    record.free_rects = static_cast<uint32_t>(board.free_rectangles.size());
+    record.material = board.material;
+    record.rotation = static_cast<uint16_t>(rotation);
+    record.x = board.free_rectangles[rect].x;
+    record.y = board.free_rectangles[rect].y;
+    replay_->record(record);
 }
 
-bool Nester::try_place_part(Part& part, Board& board) {
-    // Store original state
-    double original_width = part.width;
-    double original_height = part.height;
-    int original_rotation = part.rotation;
+// Try the footprints allowed by a rotation mask, upright first. Instantiated
+// per footprint combination so the common "no rotation" and "0/90" cases
+// compile to straight-line code with no loop over orientations.
+template <bool Upright, bool Turned>
+bool Nester::place_oriented(const PartStore& parts, uint32_t part, Board& board,
+                            std::vector<Placement>& placements) {
+    const double w = parts.width[part];
+    const double h = parts.height[part];
+    const RotationMask mask = parts.rotations[part];
+    size_t rect;
     
-    // Try each allowed rotation
-    for (int rotation : part.allowed_rotations) {
-        part.rotation = rotation;
-        
-        double w, h;
-        part.get_rotated_dimensions(rotation, w, h);
-        
-        double x, y;
-        if (board.find_best_position(w, h, settings_.kerf_width, x, y)) {
-            board.add_part(&part, x, y, settings_.kerf_width);
+    if constexpr (Upright) {
+        if (find_position(board, w, h, rect)) {
+            int rotation = (mask & (ROTATE_0 | ROTATE_0_MIRRORED)) ? 0 : 180;
+            NEST_PROFILE(replay_, record_decision(board, part, rotation, rect));
+            const Rect& at = board.free_rectangles[rect];
+            board.add_part(parts, part, rotation, at.x, at.y, settings_.kerf_width, placements);
             return true;
         }
     }
+    if constexpr (Turned) {
+        if (find_position(board, h, w, rect)) {
+            int rotation = (mask & (ROTATE_90 | ROTATE_90_MIRRORED)) ? 90 : 270;
+            NEST_PROFILE(replay_, record_decision(board, part, rotation, rect));
+            const Rect& at = board.free_rectangles[rect];
+            board.add_part(parts, part, rotation, at.x, at.y, settings_.kerf_width, placements);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Nester::try_place_part(const PartStore& parts, uint32_t part, Board& board,
+                            std::vector<Placement>& placements) {
+    // Orientations sharing a footprint are interchangeable for placement,
+    // so only the two footprints need to be tried
+    const RotationMask mask = parts.rotations[part];
+    const bool upright = (mask & ROTATE_UPRIGHT) != 0;
+    const bool turned = (mask & ROTATE_TURNED) != 0;
     
-    // Restore original state if placement failed
-    part.width = original_width;
-    part.height = original_height;
-    part.rotation = original_rotation;
-    
+    if (upright && turned) return place_oriented<true, true>(parts, part, board, placements);
+    if (upright) return place_oriented<true, false>(parts, part, board, placements);
+    if (turned) return place_oriented<false, true>(parts, part, board, placements);
     return false;
 }
 
-std::vector<Board> Nester::nest_parts(
-    std::vector<Part>& parts,
-    const std::string& material,
+void Nester::nest_parts(
+    const PartStore& parts,
+    MaterialId material,
     double board_width,
-    double board_height) {
+    double board_height,
+    Solution& solution) {
     
-    std::vector<Board> boards;
+    size_t first_board = solution.boards.size();
+    NEST_PROFILE(profile_, profile_->materials.push_back({material, parts.size(), 0, 0, PerfSample(), AllocSample()}));
+    NEST_PROFILE_SCOPE(profile_, profile_->materials.back().ms);
+    NEST_PERF_SCOPE(profile_, profile_->materials.back().counters);
+    NEST_ALLOC_SCOPE(profile_, profile_->materials.back().allocs);
+    NEST_TRACE_SPAN(material_span, trace_, material_name(material), "material");
+    NEST_PROFILE(trace_, material_span.arg("parts", static_cast<double>(parts.size())));
     
-    // Sort parts by area (largest first) for better packing
-    std::sort(parts.begin(), parts.end(),
-        [](const Part& a, const Part& b) {
-            return a.area() > b.area();
-        });
+    // Nothing from the previous call is left in the arena
+    arena_.release();
     
-    std::vector<Part*> remaining_parts;
-    for (auto& part : parts) {
-        remaining_parts.push_back(&part);
+    // Sort part indices by area (largest first) for better packing;
+    // the parts themselves stay where they are
+    std::pmr::vector<uint32_t> order(parts.size(), &arena_);
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    {
+        NEST_PROFILE_SCOPE(profile_, profile_->sort_ms);
+        std::sort(order.begin(), order.end(),
+            [&parts](uint32_t a, uint32_t b) {
+                return parts.area(a) > parts.area(b);
+            });
     }
     
     int board_count = 0;
@@ -143,18 +305,97 @@ std::vector<Board> Nester::nest_parts(
     size_t placed_count = 0;
     
     std::cout << "Starting nesting for " << total_parts << " parts on material: " 
-              << material << std::endl;
+              << material_name(material) << std::endl;
     
-    while (!remaining_parts.empty()) {
+    // Number the distinct shapes. Free space on an open board only shrinks,
+    // so once a shape fails on a board every later part of that shape fails
+    // too; failed_on_board[shape] remembers the board it last failed on.
+    //
+    // suffix_min[k] bounds the footprints of the parts from sorted position
+    // k on. Parts keep their sorted order from board to board, so when the
+    // board's free space is below the bound at a part's position nothing
+    // left can fit and the board is closed without visiting the rest.
+    // Already placed parts only make the bound looser.
+    const double kerf = settings_.kerf_width;
+    std::pmr::vector<uint32_t> shape_at(order.size(), &arena_);
+    std::pmr::vector<int> failed_on_board(&arena_);
+    std::pmr::vector<FitBound> suffix_min(order.size() + 1, &arena_);
+    {
+        NEST_PROFILE_SCOPE(profile_, profile_->group_ms);
+        std::pmr::unordered_map<Shape, uint32_t, ShapeHash> shape_ids(&arena_);
+        for (size_t k = 0; k < order.size(); k++) {
+            uint32_t part = order[k];
+            Shape shape{parts.width[part], parts.height[part], parts.rotations[part]};
+            auto inserted = shape_ids.emplace(shape, static_cast<uint32_t>(shape_ids.size()));
+            shape_at[k] = inserted.first->second;
+        }
+        failed_on_board.assign(shape_ids.size(), 0);
+        
+        suffix_min.back() = {INFINITY, INFINITY, INFINITY};
+        for (size_t k = order.size(); k-- > 0;) {
+            uint32_t part = order[k];
+            double a = parts.width[part] + kerf;
+            double b = parts.height[part] + kerf;
+            const FitBound& next = suffix_min[k + 1];
+            suffix_min[k] = {std::min(std::min(a, b), next.short_side),
+                             std::min(std::max(a, b), next.long_side),
+                             std::min(a * b, next.area)};
+        }
+    }
+    
+    // Sorted positions of the parts still to place. Parts that did not fit
+    // go to next_remaining, which is swapped in after each board so the two
+    // lists reuse their arena storage.
+    std::pmr::vector<uint32_t> remaining(order.size(), &arena_);
+    for (uint32_t k = 0; k < remaining.size(); k++) {
+        remaining[k] = k;
+    }
+    std::pmr::vector<uint32_t> next_remaining(&arena_);
+    next_remaining.reserve(remaining.size());
+    
+    Board current_board(0, material, board_width, board_height, &arena_);
+    auto loop_start = std::chrono::steady_clock::now();
+    
+    while (!remaining.empty()) {
         board_count++;
-        boards.emplace_back(board_count, material, board_width, board_height);
-        Board& current_board = boards.back();
+        NEST_TRACE_SPAN(board_span, trace_, "board", "board");
+        current_board.reset(board_count, static_cast<uint32_t>(solution.placements.size()));
         
-        std::vector<Part*> parts_for_next_board;
+        next_remaining.clear();
         
-        for (Part* part : remaining_parts) {
-            if (try_place_part(*part, current_board)) {
+        // Sorted position from which nothing fits the board any more. The
+        // bounds only grow with the position and the board's free space only
+        // shrinks, so it only moves down; after each placement one probe at
+        // close_from - 1 tells whether it needs a binary search at all.
+        size_t close_from = order.size();
+        
+        size_t remaining_count = remaining.size();
+        size_t visited = 0;
+        for (; visited < remaining_count; visited++) {
+            uint32_t k = remaining[visited];
+            
+            if (k >= close_from) {
+                stats_.boards_closed_early++;
+                stats_.parts_skipped_by_close += remaining_count - visited;
+                next_remaining.insert(next_remaining.end(), remaining.begin() + visited, remaining.end());
+                break;
+            }
+            
+            int& failed_on = failed_on_board[shape_at[k]];
+            if (failed_on == board_count) {
+                stats_.parts_skipped++;
+                next_remaining.push_back(k);
+                continue;
+            }
+            
+            if (try_place_part(parts, order[k], current_board, solution.placements)) {
                 placed_count++;
+                stats_.free_rects_peak = std::max<uint64_t>(stats_.free_rects_peak,
+                                                            current_board.free_rectangles.size());
+                NEST_PROFILE(profile_, profile_->add_part_calls++);
+                NEST_PROFILE(trace_, trace_->counter("free_rects",
+                    static_cast<double>(current_board.free_rectangles.size())));
+                close_from = current_board.first_unfit(suffix_min.data(), k + 1, close_from);
                 
                 // Progress reporting every 10 parts or at end
                 if (placed_count % 10 == 0 || placed_count == total_parts) {
@@ -162,31 +403,44 @@ std::vector<Board> Nester::nest_parts(
                               << " parts placed on " << board_count << " boards" << std::endl;
                 }
             } else {
-                parts_for_next_board.push_back(part);
+                failed_on = board_count;
+                next_remaining.push_back(k);
             }
         }
+        stats_.part_attempts += visited;
         
         // Check if we made progress
-        if (current_board.placed_parts.empty()) {
+        if (current_board.placed_count == 0) {
             // No parts could be placed - error condition
-            if (!remaining_parts.empty()) {
-                Part* problem_part = remaining_parts[0];
-                std::cerr << "ERROR: Unable to place part '" << problem_part->id 
-                          << "' (" << problem_part->width << "x" << problem_part->height 
+            if (!remaining.empty()) {
+                uint32_t problem_part = order[remaining[0]];
+                std::cerr << "ERROR: Unable to place part '" << part_name(parts, problem_part) 
+                          << "' (" << parts.width[problem_part] << "x" << parts.height[problem_part] 
                           << "mm) on board (" << board_width << "x" << board_height 
-                          << "mm) for material '" << material << "'" << std::endl;
-                boards.pop_back(); // Remove empty board
-                break;
+                          << "mm) for material '" << material_name(material) << "'" << std::endl;
+                break; // Drop the empty board
             }
         }
         
-        remaining_parts = std::move(parts_for_next_board);
+        solution.boards.push_back(current_board.finish(settings_.min_offcut_size, solution.offcuts));
+        NEST_PROFILE(trace_, {
+            const BoardRecord& board = solution.boards.back();
+            board_span.arg("board", board.id);
+            board_span.arg("parts", board.placement_count);
+            board_span.arg("visited", static_cast<double>(visited));
+            board_span.arg("waste_percent", board.waste_percentage());
+            trace_->counter("waste_percent", board.waste_percentage());
+        });
+        
+        remaining.swap(next_remaining);
     }
     
-    std::cout << "Nesting complete: " << placed_count << "/" << total_parts 
-              << " parts placed on " << boards.size() << " boards" << std::endl;
+    stats_.placement_ms += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - loop_start).count();
+    NEST_PROFILE(profile_, profile_->materials.back().placements = placed_count);
     
-    return boards;
+    std::cout << "Nesting complete: " << placed_count << "/" << total_parts 
+              << " parts placed on " << (solution.boards.size() - first_board) << " boards" << std::endl;
 }
 
 } // namespace AutoNestCut
@@ -1,65 +1,106 @@
 #pragma once
 
 #include "geometry.h"
+#include "part_store.h"
+#include "profile.h"
+#include "replay_log.h"
+#include "solution.h"
+#include <algorithm>
+#include "string_table.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 
 namespace AutoNestCut {
 
-// Part to be placed
-struct Part {
-    std::string id;
-    std::string material;
-    double width;
-    double height;
-    std::string grain_direction;
-    std::vector<int> allowed_rotations; // 0, 90, 180, 270
-    
-    // Placement result (filled by nesting algorithm)
-    double x = 0;
-    double y = 0;
-    int rotation = 0;
-    int board_id = -1;
-    
-    double area() const { return width * height; }
-    
-    // Get dimensions after rotation
-    void get_rotated_dimensions(int rot, double& w, double& h) const {
-        if (rot == 90 || rot == 270) {
-            w = height;
-            h = width;
-        } else {
-            w = width;
-            h = height;
-        }
-    }
+// Smallest footprint measures (kerf included) over a set of parts. Whatever
+// orientation a part is placed in, its short side, long side and area are at
+// least these, which gives cheap necessary conditions for a fit.
+struct FitBound {
+    double short_side;
+    double long_side;
+    double area;
 };
 
-// Board (sheet stock)
+// Board (sheet stock) being filled. Only the board currently open is kept
+// as a Board; once finished it is reduced to a BoardRecord plus its offcuts
+// in the Solution and the Board is reset for the next sheet. Move-only.
 struct Board {
     int id;
-    std::string material;
+    MaterialId material;
     double width;
     double height;
-    std::vector<Rect> free_rectangles;
-    std::vector<Part*> placed_parts;
+    std::pmr::vector<Rect> free_rectangles;
+    std::pmr::vector<Rect> scratch_rectangles; // Reused by add_part to rebuild free_rectangles
+    uint32_t first_placement = 0;              // This board's range in Solution::placements
+    uint32_t placed_count = 0;
+    double placed_area = 0;
+    
+    // Bounds over the free rectangles, kept current by add_part. Free space
+    // only shrinks while a board is open, so these only ever decrease.
+    double max_free_width = 0;
+    double max_free_height = 0;
+    double max_free_area = 0;
     
-    Board(int id_, const std::string& mat, double w, double h)
-        : id(id_), material(mat), width(w), height(h) {
+    Board(int id_, MaterialId mat, double w, double h,
+          std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : id(id_), material(mat), width(w), height(h),
+          free_rectangles(memory), scratch_rectangles(memory) {
         // Initialize with one large free rectangle
         free_rectangles.emplace_back(0, 0, w, h);
+        update_free_bounds();
     }
     
+    Board(Board&&) = default;
+    Board& operator=(Board&&) = default;
+    Board(const Board&) = delete;
+    Board& operator=(const Board&) = delete;
+    
+    // Start over as an empty board, keeping the vectors' capacity
+    void reset(int id_, uint32_t first);
+    
+    // O(1) pre-check for find_best_position: false means no free rectangle
+    // can hold the part, true means a full search is needed
+    bool may_fit(double part_width, double part_height, double kerf) const {
+        if (placed_count == 0) return true; // Exact-fit special case
+        double effective_width = part_width + kerf;
+        double effective_height = part_height + kerf;
+        return effective_width <= max_free_width &&
+               effective_height <= max_free_height &&
+               effective_width * effective_height <= max_free_area;
+    }
+    
+    // O(1) check whether any part within `bound` might fit; false means
+    // none can
+    bool may_fit_any(const FitBound& bound) const {
+        return bound.short_side <= std::min(max_free_width, max_free_height) &&
+               bound.long_side <= std::max(max_free_width, max_free_height) &&
+               bound.area <= max_free_area;
+    }
+    
+    // For bounds that are non-decreasing over [from, to), the first index
+    // whose parts cannot fit any more, or `to` if they all may
+    size_t first_unfit(const FitBound* bounds, size_t from, size_t to) const;
+    
+    // Index of the free rectangle find_best_position would place the part
+    // at, or free_rectangles.size() if none can hold it
+    size_t best_rect(double part_width, double part_height, double kerf) const;
+    
     // Find best position for a part with given dimensions
     bool find_best_position(double part_width, double part_height, 
                            double kerf, double& out_x, double& out_y);
     
-    // Add part to board and update free rectangles
-    void add_part(Part* part, double x, double y, double kerf);
+    // Record the part in `placements` and update free rectangles
+    void add_part(const PartStore& parts, uint32_t part, int rotation,
+                  double x, double y, double kerf, std::vector<Placement>& placements);
+    
+    // Close the board: append the free rectangles at least `min_offcut` on
+    // both sides to `offcuts`, drop the free-rect state and return the record
+    BoardRecord finish(double min_offcut, std::vector<Rect>& offcuts);
     
-    double used_area() const;
-    double waste_percentage() const;
+    void update_free_bounds();
 };
 
 // Nesting settings
@@ -67,26 +108,87 @@ struct Settings {
     double kerf_width = 3.0;
     bool allow_rotation = true;
     int timeout_ms = 60000;
+    double min_offcut_size = 100.0; // Smallest leftover side reported as an offcut
+};
+
+// Counters for the work the placement loop did and avoided
+struct NestStats {
+    uint64_t fit_checks = 0;         // find_best_position calls
+    uint64_t fit_checks_skipped = 0; // Rejected by the board's free-space bounds
+    uint64_t parts_skipped = 0;      // Skipped because an identical part already failed on the board
+    uint64_t part_attempts = 0;      // Parts visited by the placement loop
+    uint64_t boards_closed_early = 0;
+    uint64_t parts_skipped_by_close = 0; // Not visited because their board was closed early
+    uint64_t free_rects_peak = 0;    // Longest free-rectangle list on any board
+    double placement_ms = 0;         // Time spent in the placement loop
+    
+    // Estimate of the time early closing saved, at the average cost of a visit
+    double close_time_saved_ms() const {
+        if (part_attempts == 0) return 0;
+        return placement_ms * static_cast<double>(parts_skipped_by_close) / static_cast<double>(part_attempts);
+    }
 };
 
 // Main nesting engine
 class Nester {
 public:
-    Nester(const Settings& settings);
+    // The optional tables resolve handles in progress and error messages
+    Nester(const Settings& settings,
+           const StringTable* materials = nullptr,
+           const StringTable* part_ids = nullptr);
     
     // Nest parts onto boards
-    // Returns list of boards with placed parts
-    std::vector<Board> nest_parts(
-        std::vector<Part>& parts,
-        const std::string& material,
+    // Appends the finished boards, placements and offcuts to `solution`. The
+    // part store is only read; placements refer to parts by index into it.
+    void nest_parts(
+        const PartStore& parts,
+        MaterialId material,
         double board_width,
-        double board_height
+        double board_height,
+        Solution& solution
     );
     
+    // Totals over every nest_parts call so far
+    const NestStats& stats() const { return stats_; }
+    
+    // Record phase times and hot-path counters into `profile` (null to stop)
+    void set_profile(Profile* profile) { profile_ = profile; }
+    
+    // Record material and board spans and placement counters into `trace`
+    void set_trace(Trace* trace) { trace_ = trace; }
+    
+    // Record every placement decision into `replay` (null to stop)
+    void set_replay(ReplayLog* replay) { replay_ = replay; }
+    
 private:
     Settings settings_;
+    const StringTable* materials_;
+    const StringTable* part_ids_;
+    NestStats stats_;
+    Profile* profile_ = nullptr;
+    Trace* trace_ = nullptr;
+    ReplayLog* replay_ = nullptr;
+    
+    // Arena for one nest_parts call's solver state (free rectangles, work
+    // lists). Never frees individually; released in one go when the next call
+    // starts, so memory does not grow with the number of materials.
+    std::pmr::monotonic_buffer_resource arena_;
+    
+    std::string material_name(MaterialId material) const;
+    std::string part_name(const PartStore& parts, uint32_t part) const;
+    
+    // Free rectangle to place a w x h footprint at (see Board::best_rect)
+    bool find_position(const Board& board, double w, double h, size_t& rect);
+    
+    // Log the choice find_position made, before add_part changes the list
+    void record_decision(const Board& board, uint32_t part, int rotation, size_t rect);
+    
+    bool try_place_part(const PartStore& parts, uint32_t part, Board& board,
+                        std::vector<Placement>& placements);
     
-    bool try_place_part(Part& part, Board& board);
+    template <bool Upright, bool Turned>
+    bool place_oriented(const PartStore& parts, uint32_t part, Board& board,
+                        std::vector<Placement>& placements);
 };
 
 } // namespace AutoNestCut
@@ -0,0 +1,27 @@
+#include "part_store.h"
+
+namespace AutoNestCut {
+
+uint32_t PartStore::add(const Part& part) {
+    uint32_t index = static_cast<uint32_t>(size());
+    width.push_back(part.width);
+    height.push_back(part.height);
+    rotations.push_back(ROTATE_0);
+    id.push_back(part.id);
+    grain.push_back(part.grain);
+    type_index.push_back(part.type_index);
+    instance.push_back(part.instance);
+    return index;
+}
+
+void PartStore::reserve(size_t count) {
+    width.reserve(count);
+    height.reserve(count);
+    rotations.reserve(count);
+    id.reserve(count);
+    grain.reserve(count);
+    type_index.reserve(count);
+    instance.reserve(count);
+}
+
+} // namespace AutoNestCut
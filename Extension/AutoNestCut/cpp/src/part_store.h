@@ -0,0 +1,88 @@
+#pragma once
+
+#include "string_table.h"
+#include <cstdint>
+#include <vector>
+
+namespace AutoNestCut {
+
+using MaterialId = uint16_t;
+using GrainId = uint16_t;
+
+// Allowed orientations as a bitmask. Mirrored orientations are for
+// double-sided stock where a part may be flipped face down.
+using RotationMask = uint8_t;
+
+enum : RotationMask {
+    ROTATE_0 = 1 << 0,
+    ROTATE_90 = 1 << 1,
+    ROTATE_180 = 1 << 2,
+    ROTATE_270 = 1 << 3,
+    ROTATE_0_MIRRORED = 1 << 4,
+    ROTATE_90_MIRRORED = 1 << 5,
+    ROTATE_180_MIRRORED = 1 << 6,
+    ROTATE_270_MIRRORED = 1 << 7,
+    
+    // Orientations grouped by the footprint they occupy on the board
+    ROTATE_UPRIGHT = ROTATE_0 | ROTATE_180 | ROTATE_0_MIRRORED | ROTATE_180_MIRRORED,
+    ROTATE_TURNED = ROTATE_90 | ROTATE_270 | ROTATE_90_MIRRORED | ROTATE_270_MIRRORED
+};
+
+// One part as read from the request. Text fields are handles: `id` indexes the
+// request's part ID arena, `material` and `grain` index its interned material
+// and grain direction tables. Strings are only resolved back when writing
+// output.
+struct Part {
+    double width = 0;
+    double height = 0;
+    StringId id = 0;
+    MaterialId material = 0;
+    GrainId grain = 0;
+    
+    // Row in the request's part-type table and instance number within it
+    uint32_t type_index = 0;
+    uint32_t instance = 0;
+};
+
+static_assert(sizeof(Part) <= 64, "Part should fit in a cache line");
+
+// Structure-of-arrays storage for the parts of one material.
+//
+// The hot arrays (geometry) are what sorting and the placement loop touch, so
+// they are kept densely packed and separate from the cold metadata, which is
+// only read when resolving output. The store is read-only during nesting:
+// parts never move, nesting iterates index permutations into these arrays and
+// records its results in a separate Solution.
+struct PartStore {
+    // Hot: geometry
+    std::vector<double> width;
+    std::vector<double> height;
+    std::vector<RotationMask> rotations;
+    
+    // Cold: metadata
+    std::vector<StringId> id;
+    std::vector<GrainId> grain;
+    std::vector<uint32_t> type_index;
+    std::vector<uint32_t> instance;
+    
+    uint32_t add(const Part& part);
+    void reserve(size_t count);
+    
+    size_t size() const { return width.size(); }
+    bool empty() const { return width.empty(); }
+    
+    double area(uint32_t i) const { return width[i] * height[i]; }
+    
+    // Get dimensions after rotation
+    void get_rotated_dimensions(uint32_t i, int rot, double& w, double& h) const {
+        if (rot == 90 || rot == 270) {
+            w = height[i];
+            h = width[i];
+        } else {
+            w = width[i];
+            h = height[i];
+        }
+    }
+};
+
+} // namespace AutoNestCut
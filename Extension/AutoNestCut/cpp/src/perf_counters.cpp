@@ -0,0 +1,100 @@
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace AutoNestCut {
+
+#ifdef __linux__
+
+namespace {
+
+const uint64_t EVENT_CONFIG[PerfCounters::EVENT_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int open_event(uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1; // Allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+uint64_t read_event(int fd) {
+    if (fd < 0) return 0;
+    uint64_t values[3]; // value, time enabled, time running
+    if (::read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values))) return 0;
+    if (values[2] == 0) return 0;
+    if (values[2] < values[1]) {
+        return static_cast<uint64_t>(static_cast<double>(values[0]) *
+                                     static_cast<double>(values[1]) / static_cast<double>(values[2]));
+    }
+    return values[0];
+}
+
+} // namespace
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+void PerfCounters::close() {
+    for (int& fd : fds_) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+}
+
+bool PerfCounters::open(std::string& error) {
+    for (int event = 0; event < EVENT_COUNT; event++) {
+        fds_[event] = open_event(EVENT_CONFIG[event]);
+        if (fds_[event] < 0 && event <= INSTRUCTIONS) {
+            error = std::string("perf_event_open failed: ") + std::strerror(errno);
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+PerfSample PerfCounters::read() const {
+    PerfSample sample;
+    sample.cycles = read_event(fds_[CYCLES]);
+    sample.instructions = read_event(fds_[INSTRUCTIONS]);
+    sample.cache_misses = read_event(fds_[CACHE_MISSES]);
+    sample.branch_misses = read_event(fds_[BRANCH_MISSES]);
+    return sample;
+}
+
+#else
+
+PerfCounters::~PerfCounters() = default;
+
+void PerfCounters::close() {}
+
+bool PerfCounters::open(std::string& error) {
+    error = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+PerfSample PerfCounters::read() const {
+    return PerfSample();
+}
+
+#endif
+
+} // namespace AutoNestCut
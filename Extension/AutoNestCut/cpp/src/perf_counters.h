@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace AutoNestCut {
+
+// Hardware event counts over an interval
+struct PerfSample {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;  // Last-level cache misses
+    uint64_t branch_misses = 0;
+
+    PerfSample& operator+=(const PerfSample& other) {
+        cycles += other.cycles;
+        instructions += other.instructions;
+        cache_misses += other.cache_misses;
+        branch_misses += other.branch_misses;
+        return *this;
+    }
+
+    PerfSample operator-(const PerfSample& other) const {
+        PerfSample diff;
+        diff.cycles = cycles - other.cycles;
+        diff.instructions = instructions - other.instructions;
+        diff.cache_misses = cache_misses - other.cache_misses;
+        diff.branch_misses = branch_misses - other.branch_misses;
+        return diff;
+    }
+
+    double ipc() const {
+        return cycles > 0 ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0;
+    }
+};
+
+// User-space hardware counters for the calling thread, read through
+// perf_event_open. Only available on Linux, and only where the kernel
+// exposes a PMU and perf_event_paranoid allows it (often not in containers
+// or VMs); open() reports why otherwise. Events the CPU lacks read as 0 and
+// are left out of has().
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, EVENT_COUNT };
+
+    PerfCounters() = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Needs at least cycles and instructions
+    bool open(std::string& error);
+    bool is_open() const { return fds_[CYCLES] >= 0; }
+    bool has(Event event) const { return fds_[event] >= 0; }
+
+    // Running totals since open(), scaled up if the kernel multiplexed them
+    PerfSample read() const;
+
+private:
+    void close();
+
+    int fds_[EVENT_COUNT] = {-1, -1, -1, -1};
+};
+
+} // namespace AutoNestCut
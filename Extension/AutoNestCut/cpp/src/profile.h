@@ -0,0 +1,184 @@
+#pragma once
+
+#include "alloc_tracker.h"
+#include "part_store.h"
+#include "perf_counters.h"
+#include "trace.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Instrumentation behind --profile, --perf-counters, --alloc-stats and
+// --trace. Building with -DAUTONESTCUT_PROFILE=0 (CMake option
+// AUTONESTCUT_PROFILE=OFF) turns the NEST_* probe macros into nothing;
+// otherwise each probe costs a null check unless a Profile or Trace is
+// attached.
+#ifndef AUTONESTCUT_PROFILE
+#define AUTONESTCUT_PROFILE 1
+#endif
+
+namespace AutoNestCut {
+
+// Per-run phase times and hot-path counters
+struct Profile {
+    struct MaterialTime {
+        MaterialId material;
+        size_t parts;
+        double ms;
+        size_t placements = 0;
+        PerfSample counters;
+        AllocSample allocs;
+    };
+
+    double read_ms = 0;  // Opening / mapping the input
+    double parse_ms = 0; // Parsing, including grouping parts by material
+    double order_ms = 0; // Ordering materials by name
+    double group_ms = 0; // Numbering distinct shapes and fit bounds, per material
+    double sort_ms = 0;  // Area sort of each material's parts
+    double write_ms = 0; // Writing placements and boards
+    std::vector<MaterialTime> materials; // Whole nest_parts call per material
+
+    uint64_t find_position_calls = 0; // Full free-rect searches
+    uint64_t add_part_calls = 0;
+    uint64_t free_rects_scanned = 0;  // Sum of list lengths over the searches
+    uint64_t free_rects_max = 0;
+
+    // Hardware counters (--perf-counters), when they could be opened
+    const PerfCounters* counters = nullptr;
+    PerfSample parse_counters;
+    PerfSample write_counters;
+
+    // Heap activity (--alloc-stats), when allocation tracking is on
+    bool alloc_tracking = false;
+    AllocSample parse_allocs;
+    AllocSample write_allocs;
+
+    double nest_ms() const {
+        double total = 0;
+        for (const auto& m : materials) total += m.ms;
+        return total;
+    }
+
+    PerfSample nest_counters() const {
+        PerfSample total;
+        for (const auto& m : materials) total += m.counters;
+        return total;
+    }
+
+    AllocSample nest_allocs() const {
+        AllocSample total;
+        for (const auto& m : materials) total += m.allocs;
+        return total;
+    }
+
+    size_t placements() const {
+        size_t total = 0;
+        for (const auto& m : materials) total += m.placements;
+        return total;
+    }
+
+    double free_rects_avg() const {
+        return find_position_calls > 0 ?
+            static_cast<double>(free_rects_scanned) / static_cast<double>(find_position_calls) : 0;
+    }
+};
+
+// Adds the time until the end of the scope to a Profile field
+class ProfileTimer {
+public:
+    ProfileTimer(Profile* profile, double* field)
+        : field_(profile ? field : nullptr) {
+        if (field_) start_ = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileTimer() {
+        if (field_) {
+            *field_ += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_).count();
+        }
+    }
+
+    ProfileTimer(const ProfileTimer&) = delete;
+    ProfileTimer& operator=(const ProfileTimer&) = delete;
+
+private:
+    double* field_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Adds the hardware counts until the end of the scope to a PerfSample
+class PerfScope {
+public:
+    PerfScope(const PerfCounters* counters, PerfSample* target)
+        : counters_(target ? counters : nullptr), target_(target) {
+        if (counters_) start_ = counters_->read();
+    }
+
+    ~PerfScope() {
+        if (counters_) *target_ += counters_->read() - start_;
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    const PerfCounters* counters_;
+    PerfSample* target_;
+    PerfSample start_;
+};
+
+// Adds the heap activity until the end of the scope to an AllocSample
+class AllocScope {
+public:
+    explicit AllocScope(AllocSample* target)
+        : target_(target) {
+        if (target_) start_ = alloc_snapshot();
+    }
+
+    ~AllocScope() {
+        if (target_) *target_ += alloc_snapshot() - start_;
+    }
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    AllocSample* target_;
+    AllocSample start_;
+};
+
+} // namespace AutoNestCut
+
+#define NEST_PROFILE_CONCAT_(a, b) a##b
+#define NEST_PROFILE_CONCAT(a, b) NEST_PROFILE_CONCAT_(a, b)
+
+#if AUTONESTCUT_PROFILE
+// Add the time until the end of the scope to `target`, a double inside the
+// profile; nothing is timed when `profile` is null
+#define NEST_PROFILE_SCOPE(profile, target) \
+    ::AutoNestCut::ProfileTimer NEST_PROFILE_CONCAT(profile_timer_, __LINE__)( \
+        (profile), (profile) ? &(target) : nullptr)
+// Add the hardware counts until the end of the scope to `target`, a
+// PerfSample inside the profile; nothing is read without counters
+#define NEST_PERF_SCOPE(profile, target) \
+    ::AutoNestCut::PerfScope NEST_PROFILE_CONCAT(perf_scope_, __LINE__)( \
+        (profile) ? (profile)->counters : nullptr, (profile) ? &(target) : nullptr)
+// Add the heap activity until the end of the scope to `target`, an
+// AllocSample inside the profile, when allocation tracking is on
+#define NEST_ALLOC_SCOPE(profile, target) \
+    ::AutoNestCut::AllocScope NEST_PROFILE_CONCAT(alloc_scope_, __LINE__)( \
+        (profile) && (profile)->alloc_tracking ? &(target) : nullptr)
+// Run the statements only in profiling builds with a profile attached
+#define NEST_PROFILE(profile, ...) \
+    do { if (profile) { __VA_ARGS__; } } while (0)
+// Trace span named `var` covering the rest of the scope (trace may be null);
+// attach args with NEST_PROFILE(trace, var.arg(...))
+#define NEST_TRACE_SPAN(var, trace, name, category) \
+    ::AutoNestCut::TraceSpan var((trace), (name), (category))
+#else
+#define NEST_PROFILE_SCOPE(profile, target) ((void)0)
+#define NEST_PERF_SCOPE(profile, target) ((void)0)
+#define NEST_ALLOC_SCOPE(profile, target) ((void)0)
+#define NEST_PROFILE(profile, ...) ((void)0)
+#define NEST_TRACE_SPAN(var, trace, name, category) ((void)0)
+#endif
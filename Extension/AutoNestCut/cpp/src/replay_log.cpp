@@ -0,0 +1,87 @@
+#include "replay_log.h"
+#include <cstring>
+
+namespace AutoNestCut {
+
+namespace {
+
+const char MAGIC[4] = {'A', 'N', 'R', 'P'};
+
+} // namespace
+
+ReplayLog::~ReplayLog() {
+    if (file_) std::fclose(file_);
+}
+
+bool ReplayLog::open(const std::string& path, std::string& error) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        error = "Cannot open replay log: " + path;
+        return false;
+    }
+    records_.reserve(BLOCK);
+    // Placeholder header, rewritten with the record count by close()
+    Replay::Header header{};
+    failed_ = std::fwrite(&header, sizeof(header), 1, file_) != 1;
+    return true;
+}
+
+void ReplayLog::flush_block() {
+    if (!records_.empty() &&
+        std::fwrite(records_.data(), sizeof(Replay::Record), records_.size(), file_) != records_.size()) {
+        failed_ = true;
+    }
+    written_ += records_.size();
+    records_.clear();
+}
+
+bool ReplayLog::close(uint64_t job_hash, uint16_t flags) {
+    if (!file_) return true;
+    flush_block();
+
+    Replay::Header header{};
+    std::memcpy(header.magic, MAGIC, 4);
+    header.version = Replay::VERSION;
+    header.flags = flags;
+    header.job_hash = job_hash;
+    header.record_count = written_;
+    if (std::fseek(file_, 0, SEEK_SET) != 0 || std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+        failed_ = true;
+    }
+    if (std::fclose(file_) != 0) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+}
+
+bool read_replay_log(const std::string& path, Replay::Header& header,
+                     std::vector<Replay::Record>& records, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "Cannot open replay log: " + path;
+        return false;
+    }
+    long size = -1;
+    if (std::fseek(file, 0, SEEK_END) == 0) {
+        size = std::ftell(file);
+        std::rewind(file);
+    }
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+              std::memcmp(header.magic, MAGIC, 4) == 0;
+    if (!ok) {
+        error = "Not a replay log: " + path;
+    } else if (header.version != Replay::VERSION) {
+        error = "Unsupported replay log version " + std::to_string(header.version);
+        ok = false;
+    } else if (size < 0 || static_cast<uint64_t>(size - sizeof(header)) / sizeof(Replay::Record) < header.record_count) {
+        error = "Truncated replay log: " + path;
+        ok = false;
+    } else {
+        records.resize(header.record_count);
+        ok = std::fread(records.data(), sizeof(Replay::Record), records.size(), file) == records.size();
+        if (!ok) error = "Cannot read replay log: " + path;
+    }
+    std::fclose(file);
+    return ok;
+}
+
+} // namespace AutoNestCut
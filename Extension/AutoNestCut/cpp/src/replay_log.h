@@ -0,0 +1,86 @@
+#pragma once
+
+#include "part_store.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Log of the placement loop's decisions, one record per placed part in the
+// order they were made, for replaying and diffing runs (see nester_replay).
+//
+// File layout ("ANRP"): header | records[record_count]. Little-endian,
+// fixed-width records like the binary wire format.
+namespace Replay {
+
+constexpr uint16_t VERSION = 1;
+
+// Header flags
+constexpr uint16_t DELTA = 1; // Recorded while applying a delta request
+
+struct Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint64_t job_hash;     // job_hash() of the request
+    uint64_t record_count;
+    uint64_t reserved;
+};
+
+struct Record {
+    uint32_t part;       // Index in the material's part store
+    int32_t board_id;
+    uint32_t rect_index; // Chosen free rectangle, in the board's sorted list
+    uint32_t free_rects; // Candidates: free rectangles on the board at the time
+    MaterialId material;
+    uint16_t rotation;
+    uint32_t reserved;
+    double x;
+    double y;
+};
+
+static_assert(sizeof(Header) == 32, "replay header layout");
+static_assert(sizeof(Record) == 40, "replay record layout");
+
+} // namespace Replay
+
+// Collects Replay::Records. Opened on a file, records are buffered and
+// written in blocks; otherwise they are kept in memory (records()).
+class ReplayLog {
+public:
+    ReplayLog() = default;
+    ~ReplayLog();
+
+    ReplayLog(const ReplayLog&) = delete;
+    ReplayLog& operator=(const ReplayLog&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+
+    void record(const Replay::Record& record) {
+        records_.push_back(record);
+        if (file_ && records_.size() == BLOCK) flush_block();
+    }
+
+    // Write the header and the remaining records; false if any write failed
+    bool close(uint64_t job_hash, uint16_t flags);
+
+    // Everything recorded, when not writing to a file
+    const std::vector<Replay::Record>& records() const { return records_; }
+
+private:
+    static constexpr size_t BLOCK = 4096;
+
+    std::FILE* file_ = nullptr;
+    std::vector<Replay::Record> records_;
+    uint64_t written_ = 0;
+    bool failed_ = false;
+
+    void flush_block();
+};
+
+bool read_replay_log(const std::string& path, Replay::Header& header,
+                     std::vector<Replay::Record>& records, std::string& error);
+
+} // namespace AutoNestCut
@@ -0,0 +1,237 @@
+// Replay-log reader: summarizes the placement decisions a `nester
+// --replay-log` run recorded, and optionally re-runs the job to check that
+// the solver still makes exactly the same decisions.
+//
+// Usage: nester_replay [--steps] [--verify REQUEST] <log>
+//
+// --steps prints every decision. --verify nests REQUEST (JSON or binary)
+// again and reports the first decision that differs; it also names parts
+// and materials in the output.
+
+#include "binary_format.h"
+#include "input_source.h"
+#include "nesting.h"
+#include "replay_log.h"
+#include "request.h"
+#include "result_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace AutoNestCut;
+
+namespace {
+
+void print_usage() {
+    std::fprintf(stderr,
+        "Usage: nester_replay [--steps] [--verify REQUEST] <log>\n"
+        "  --steps           Print every decision\n"
+        "  --verify REQUEST  Re-run REQUEST and check the decisions match the log\n");
+}
+
+bool load_request(const std::string& path, NestRequest& request, std::string& error) {
+    MappedFile input;
+    if (!input.open(path, error)) return false;
+    if (input.size() >= 4 && std::memcmp(input.data(), "ANCQ", 4) == 0) {
+        return read_binary_request(input.data(), input.size(), request, error);
+    }
+    return parse_request(input.data(), input.size(), request, error);
+}
+
+// Nest the request the way nester does and collect its decisions
+void rerun(const NestRequest& request, const std::vector<MaterialId>& material_order,
+           ReplayLog& replay) {
+    Nester nester(request.settings, &request.materials, &request.part_ids);
+    nester.set_replay(&replay);
+    Solution solution;
+    solution.placements.reserve(request.part_count);
+
+    // The solver reports progress on stdout
+    std::cout.setstate(std::ios::failbit);
+    for (MaterialId material : material_order) {
+        const BoardSize& board_size = request.board_sizes[material];
+        nester.nest_parts(request.parts_by_material[material], material,
+                          board_size.width, board_size.height, solution);
+    }
+    std::cout.clear();
+}
+
+bool same_decision(const Replay::Record& a, const Replay::Record& b) {
+    return a.part == b.part && a.board_id == b.board_id && a.rect_index == b.rect_index &&
+           a.free_rects == b.free_rects && a.material == b.material && a.rotation == b.rotation &&
+           a.x == b.x && a.y == b.y;
+}
+
+class Names {
+public:
+    explicit Names(const NestRequest* request) : request_(request) {}
+
+    std::string material(MaterialId material) const {
+        if (request_ && material < request_->materials.size()) {
+            return std::string(request_->materials.get(material));
+        }
+        return "#" + std::to_string(material);
+    }
+
+    std::string part(const Replay::Record& record) const {
+        if (request_ && record.material < request_->parts_by_material.size()) {
+            const PartStore& parts = request_->parts_by_material[record.material];
+            if (record.part < parts.size()) return std::string(request_->part_ids.get(parts.id[record.part]));
+        }
+        return "#" + std::to_string(record.part);
+    }
+
+private:
+    const NestRequest* request_;
+};
+
+void print_decision(const char* label, size_t step, const Replay::Record& record, const Names& names) {
+    std::printf("%s%8zu  %-20s %5d  %-20s %4u  %5u/%-5u %9.2f %9.2f\n", label, step,
+                names.material(record.material).c_str(), record.board_id, names.part(record).c_str(),
+                record.rotation, record.rect_index, record.free_rects, record.x, record.y);
+}
+
+void print_steps(const std::vector<Replay::Record>& records, const Names& names) {
+    std::printf("%8s  %-20s %5s  %-20s %4s  %11s %9s %9s\n",
+                "step", "material", "board", "part", "rot", "rect/cands", "x", "y");
+    for (size_t i = 0; i < records.size(); i++) {
+        print_decision("", i, records[i], names);
+    }
+    std::printf("\n");
+}
+
+// Per-material totals: how long the candidate lists were and how far down
+// them the chosen rectangle was
+void print_summary(const std::vector<Replay::Record>& records, const Names& names) {
+    struct Totals {
+        MaterialId material;
+        size_t decisions = 0;
+        size_t boards = 0;
+        int last_board = -1;
+        uint64_t free_rects = 0;
+        uint32_t free_rects_max = 0;
+        uint64_t rect_index = 0;
+        size_t first_rect = 0; // Chose the first candidate
+        size_t turned = 0;     // Rotated 90 or 270 degrees
+    };
+    std::vector<Totals> totals;
+    for (const auto& record : records) {
+        if (totals.empty() || totals.back().material != record.material) {
+            totals.push_back(Totals());
+            totals.back().material = record.material;
+        }
+        Totals& t = totals.back();
+        t.decisions++;
+        if (record.board_id != t.last_board) {
+            t.boards++;
+            t.last_board = record.board_id;
+        }
+        t.free_rects += record.free_rects;
+        t.free_rects_max = std::max(t.free_rects_max, record.free_rects);
+        t.rect_index += record.rect_index;
+        if (record.rect_index == 0) t.first_rect++;
+        if (record.rotation == 90 || record.rotation == 270) t.turned++;
+    }
+
+    std::printf("%-20s %9s %6s %10s %9s %10s %8s %8s\n",
+                "material", "decisions", "boards", "cands avg", "cands max", "rect avg", "first %", "turned %");
+    for (const auto& t : totals) {
+        double n = static_cast<double>(t.decisions);
+        std::printf("%-20s %9zu %6zu %10.2f %9u %10.2f %8.1f %8.1f\n",
+                    names.material(t.material).c_str(), t.decisions, t.boards,
+                    static_cast<double>(t.free_rects) / n, t.free_rects_max,
+                    static_cast<double>(t.rect_index) / n,
+                    100.0 * static_cast<double>(t.first_rect) / n,
+                    100.0 * static_cast<double>(t.turned) / n);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bool steps = false;
+    std::string request_file;
+    std::string log_file;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--steps") == 0) {
+            steps = true;
+        } else if (std::strcmp(argv[i], "--verify") == 0 && i + 1 < argc) {
+            request_file = argv[++i];
+        } else if (argv[i][0] != '-' && log_file.empty()) {
+            log_file = argv[i];
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (log_file.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    Replay::Header header;
+    std::vector<Replay::Record> records;
+    std::string error;
+    if (!read_replay_log(log_file, header, records, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return 1;
+    }
+    std::printf("%s: %zu decisions, job %s%s\n", log_file.c_str(), records.size(),
+                hash_to_hex(header.job_hash).c_str(), (header.flags & Replay::DELTA) ? " (delta)" : "");
+
+    NestRequest request;
+    bool verify = !request_file.empty();
+#if !AUTONESTCUT_PROFILE
+    // Decisions are only recorded in profiling builds; a re-run would make none
+    if (verify) {
+        std::fprintf(stderr, "ERROR: Built without profiling support; --verify cannot record decisions\n");
+        return 1;
+    }
+#endif
+    if (verify) {
+        if (!load_request(request_file, request, error)) {
+            std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+            return 1;
+        }
+    }
+    Names names(verify ? &request : nullptr);
+
+    if (steps) print_steps(records, names);
+    print_summary(records, names);
+    if (!verify) return 0;
+
+    if (header.flags & Replay::DELTA) {
+        std::fprintf(stderr, "ERROR: Logs of delta requests cannot be re-run\n");
+        return 1;
+    }
+    std::vector<MaterialId> material_order = request.materials_by_name();
+    if (job_hash(request, material_order) != header.job_hash) {
+        std::fprintf(stderr, "ERROR: %s is not the job this log was recorded for\n", request_file.c_str());
+        return 1;
+    }
+
+    ReplayLog replay;
+    rerun(request, material_order, replay);
+    const std::vector<Replay::Record>& again = replay.records();
+
+    size_t common = std::min(records.size(), again.size());
+    for (size_t i = 0; i < common; i++) {
+        if (!same_decision(records[i], again[i])) {
+            std::printf("\nMISMATCH at step %zu\n", i);
+            print_decision("  log ", i, records[i], names);
+            print_decision("  now ", i, again[i], names);
+            std::printf("  x %.17g vs %.17g, y %.17g vs %.17g\n", records[i].x, again[i].x, records[i].y, again[i].y);
+            return 1;
+        }
+    }
+    if (records.size() != again.size()) {
+        std::printf("\nMISMATCH: log has %zu decisions, re-run made %zu\n", records.size(), again.size());
+        return 1;
+    }
+    std::printf("\nVerified: all %zu decisions match\n", records.size());
+    return 0;
+}
@@ -0,0 +1,383 @@
+#include "request.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+
+namespace AutoNestCut {
+
+namespace {
+
+// Event-driven reader for the request document. Parts are appended to their
+// material pool as soon as each part object closes, so the only memory that
+// grows with the input is the pools themselves.
+class RequestHandler : public JsonHandler {
+public:
+    explicit RequestHandler(NestRequest& request) : request_(request) {}
+
+    bool start_object() override {
+        if (skip_depth_ > 0) {
+            skip_depth_++;
+            return true;
+        }
+        switch (state_) {
+            case State::START: state_ = State::ROOT; return true;
+            case State::ROOT:
+                if (field_ == Field::SETTINGS) {
+                    state_ = State::SETTINGS;
+                } else {
+                    skip_depth_ = 1;
+                }
+                return true;
+            case State::BOARDS:
+                state_ = State::BOARD;
+                board_material_.clear();
+                board_width_ = 0;
+                board_height_ = 0;
+                return true;
+            case State::PARTS:
+                state_ = State::PART;
+                start_part(request_.part_count++);
+                return true;
+            case State::DONE: return false;
+            default: skip_depth_ = 1; return true;
+        }
+    }
+
+    bool end_object() override {
+        if (skip_depth_ > 0) {
+            skip_depth_--;
+            return true;
+        }
+        switch (state_) {
+            case State::SETTINGS: state_ = State::ROOT; break;
+            case State::BOARD:
+                request_.board_sizes[request_.material_id(board_material_)] = {board_width_, board_height_};
+                state_ = State::BOARDS;
+                break;
+            case State::PART:
+                finish_part();
+                state_ = State::PARTS;
+                break;
+            case State::ROOT: state_ = State::DONE; break;
+            default: return false;
+        }
+        field_ = Field::OTHER;
+        return true;
+    }
+
+    bool start_array() override {
+        if (skip_depth_ > 0) {
+            skip_depth_++;
+            return true;
+        }
+        if (state_ == State::ROOT && field_ == Field::BOARDS) {
+            state_ = State::BOARDS;
+        } else if (state_ == State::ROOT &&
+                   (field_ == Field::PARTS || field_ == Field::ADDED || field_ == Field::MODIFIED)) {
+            state_ = State::PARTS;
+        } else if (state_ == State::ROOT && field_ == Field::REMOVED) {
+            state_ = State::REMOVED;
+        } else if (state_ == State::START || state_ == State::DONE) {
+            return false;
+        } else {
+            if (state_ == State::PARTS) part_count_at_skip_ = request_.part_count++;
+            skip_depth_ = 1;
+        }
+        return true;
+    }
+
+    bool end_array() override {
+        if (skip_depth_ > 0) {
+            skip_depth_--;
+            if (skip_depth_ == 0 && state_ == State::PARTS) add_default_part(part_count_at_skip_);
+            return true;
+        }
+        if (state_ != State::BOARDS && state_ != State::PARTS && state_ != State::REMOVED) return false;
+        state_ = State::ROOT;
+        field_ = Field::OTHER;
+        return true;
+    }
+
+    bool key(std::string_view key) override {
+        if (skip_depth_ > 0) return true;
+        field_ = classify(key);
+        return true;
+    }
+
+    bool string(std::string_view value) override {
+        if (skip_depth_ > 0) return true;
+        if (state_ == State::PART) {
+            switch (field_) {
+                case Field::ID:
+                    part_.id = request_.part_ids.add(value);
+                    has_id_ = true;
+                    break;
+                case Field::MATERIAL:
+                    part_.material = request_.material_id(value);
+                    has_material_ = true;
+                    break;
+                case Field::GRAIN_DIRECTION:
+                    if (!value.empty()) {
+                        part_.grain = request_.grain_id(value);
+                        has_grain_ = true;
+                    }
+                    break;
+                default: break;
+            }
+        } else if (state_ == State::BOARD && field_ == Field::MATERIAL) {
+            board_material_ = value;
+        } else if (state_ == State::REMOVED) {
+            request_.removed_part_ids.emplace_back(value);
+        } else if (state_ == State::ROOT && field_ == Field::BASE_SESSION) {
+            request_.base_session = value;
+        }
+        return scalar();
+    }
+
+    bool number(double value) override {
+        if (skip_depth_ > 0) return true;
+        if (state_ == State::PART) {
+            if (field_ == Field::WIDTH) part_.width = value;
+            if (field_ == Field::HEIGHT) part_.height = value;
+        } else if (state_ == State::BOARD) {
+            if (field_ == Field::WIDTH) board_width_ = value;
+            if (field_ == Field::HEIGHT) board_height_ = value;
+        } else if (state_ == State::SETTINGS && field_ == Field::KERF) {
+            request_.settings.kerf_width = value;
+        } else if (state_ == State::SETTINGS && field_ == Field::MIN_OFFCUT_SIZE) {
+            request_.settings.min_offcut_size = value;
+        }
+        return scalar();
+    }
+
+    bool boolean(bool value) override {
+        if (skip_depth_ > 0) return true;
+        if (state_ == State::SETTINGS && field_ == Field::ALLOW_ROTATION) {
+            request_.settings.allow_rotation = value;
+        }
+        return scalar();
+    }
+
+    bool null() override {
+        if (skip_depth_ > 0) return true;
+        return scalar();
+    }
+
+    bool done() const { return state_ == State::DONE; }
+
+private:
+    enum class State { START, ROOT, SETTINGS, BOARDS, BOARD, PARTS, PART, REMOVED, DONE };
+    enum class Field {
+        OTHER, SETTINGS, BOARDS, PARTS, ID, MATERIAL, WIDTH, HEIGHT,
+        GRAIN_DIRECTION, KERF, ALLOW_ROTATION, MIN_OFFCUT_SIZE,
+        BASE_SESSION, ADDED, MODIFIED, REMOVED
+    };
+
+    NestRequest& request_;
+    State state_ = State::START;
+    Field field_ = Field::OTHER;
+    int skip_depth_ = 0;
+    size_t part_count_at_skip_ = 0;
+
+    Part part_;
+    bool has_id_ = false;
+    bool has_material_ = false;
+    bool has_grain_ = false;
+    std::string board_material_;
+    double board_width_ = 0;
+    double board_height_ = 0;
+
+    static Field classify(std::string_view key) {
+        if (key == "id") return Field::ID;
+        if (key == "material") return Field::MATERIAL;
+        if (key == "width") return Field::WIDTH;
+        if (key == "height") return Field::HEIGHT;
+        if (key == "grain_direction") return Field::GRAIN_DIRECTION;
+        if (key == "kerf") return Field::KERF;
+        if (key == "allow_rotation") return Field::ALLOW_ROTATION;
+        if (key == "min_offcut_size") return Field::MIN_OFFCUT_SIZE;
+        if (key == "settings") return Field::SETTINGS;
+        if (key == "boards") return Field::BOARDS;
+        if (key == "parts") return Field::PARTS;
+        if (key == "base_session") return Field::BASE_SESSION;
+        if (key == "added") return Field::ADDED;
+        if (key == "modified") return Field::MODIFIED;
+        if (key == "removed") return Field::REMOVED;
+        return Field::OTHER;
+    }
+
+    // Scalars directly inside the parts array still count as (empty) parts
+    bool scalar() {
+        if (state_ == State::START || state_ == State::DONE) return false;
+        if (state_ == State::PARTS) add_default_part(request_.part_count++);
+        return true;
+    }
+
+    void start_part(size_t index) {
+        part_ = Part{};
+        part_.type_index = static_cast<uint32_t>(index);
+        has_id_ = false;
+        has_material_ = false;
+        has_grain_ = false;
+    }
+
+    void add_default_part(size_t index) {
+        start_part(index);
+        finish_part();
+    }
+
+    void finish_part() {
+        if (!has_id_) part_.id = request_.part_ids.add("");
+        if (!has_material_) part_.material = request_.material_id("");
+        if (!has_grain_) part_.grain = request_.grain_id("any");
+        request_.parts_by_material[part_.material].add(part_);
+    }
+};
+
+bool parse_request(JsonReader& reader, NestRequest& request, std::string& error) {
+    if (reader.peek_type() != JsonReader::Type::OBJECT) {
+        error = "Invalid JSON format";
+        return false;
+    }
+
+    RequestHandler handler(request);
+    bool parsed = parse_events(reader, handler) && handler.done();
+    if (request.too_many_materials()) {
+        error = "Too many materials (max " + std::to_string(MAX_MATERIALS) + ")";
+        return false;
+    }
+    if (request.too_many_grains()) {
+        error = "Too many grain directions (max " + std::to_string(MAX_GRAINS) + ")";
+        return false;
+    }
+    if (!parsed) {
+        error = reader.ok() ? "Invalid JSON format" : "Invalid JSON format: " + reader.error();
+        return false;
+    }
+
+    assign_rotations(request);
+    return true;
+}
+
+} // namespace
+
+std::vector<MaterialId> NestRequest::materials_by_name() const {
+    std::vector<MaterialId> order;
+    for (size_t m = 0; m < parts_by_material.size(); m++) {
+        if (!parts_by_material[m].empty()) order.push_back(static_cast<MaterialId>(m));
+    }
+    std::sort(order.begin(), order.end(), [this](MaterialId a, MaterialId b) {
+        return materials.get(a) < materials.get(b);
+    });
+    return order;
+}
+
+size_t NestRequest::min_boards() const {
+    size_t boards = 0;
+    for (size_t m = 0; m < parts_by_material.size(); m++) {
+        const PartStore& parts = parts_by_material[m];
+        double part_area = 0;
+        for (uint32_t i = 0; i < parts.size(); i++) part_area += parts.area(i);
+        double board_area = board_sizes[m].width * board_sizes[m].height;
+        if (board_area > 0) boards += static_cast<size_t>(std::ceil(part_area / board_area));
+    }
+    return boards;
+}
+
+RotationMask parse_grain_direction(std::string_view grain) {
+    std::string lower(grain);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    
+    if (lower == "fixed" || lower == "vertical" || lower == "horizontal") {
+        return ROTATE_0; // No rotation
+    }
+    return ROTATE_0 | ROTATE_90; // Allow 90-degree rotation for "any"
+}
+
+void assign_rotations(NestRequest& request) {
+    // Resolve each distinct grain direction once
+    std::vector<RotationMask> rotations_by_grain(request.grains.size(), ROTATE_0);
+    if (request.settings.allow_rotation) {
+        for (size_t g = 0; g < rotations_by_grain.size(); g++) {
+            rotations_by_grain[g] = parse_grain_direction(request.grains.get(static_cast<StringId>(g)));
+        }
+    }
+    
+    for (auto& parts : request.parts_by_material) {
+        for (uint32_t i = 0; i < parts.size(); i++) {
+            parts.rotations[i] = rotations_by_grain[parts.grain[i]];
+        }
+    }
+}
+
+bool parse_request(char* data, size_t size, NestRequest& request, std::string& error) {
+    JsonReader reader(data, size);
+    return parse_request(reader, request, error);
+}
+
+bool parse_request(JsonInput& input, NestRequest& request, std::string& error) {
+    JsonReader reader(input);
+    return parse_request(reader, request, error);
+}
+
+bool write_request(const std::string& path, const NestRequest& request, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "Cannot open request file: " + path;
+        return false;
+    }
+
+    bool written;
+    {
+        JsonWriter json(file);
+        json.begin_object();
+
+        json.key("settings").begin_object()
+            .member("kerf", request.settings.kerf_width)
+            .member("allow_rotation", request.settings.allow_rotation)
+            .member("min_offcut_size", request.settings.min_offcut_size)
+            .end_object();
+
+        // Every material gets a board entry, in handle order, so re-reading
+        // the file interns the materials in the same order
+        json.key("boards").begin_array();
+        for (size_t m = 0; m < request.board_sizes.size(); m++) {
+            json.begin_object()
+                .member("material", request.materials.get(static_cast<StringId>(m)))
+                .member("width", request.board_sizes[m].width)
+                .member("height", request.board_sizes[m].height)
+                .end_object();
+        }
+        json.end_array();
+
+        // Grouped by material in store order, so part indices are preserved
+        json.key("parts").begin_array();
+        for (size_t m = 0; m < request.parts_by_material.size(); m++) {
+            const PartStore& parts = request.parts_by_material[m];
+            for (uint32_t i = 0; i < parts.size(); i++) {
+                json.begin_object()
+                    .member("id", request.part_ids.get(parts.id[i]))
+                    .member("material", request.materials.get(static_cast<StringId>(m)))
+                    .member("width", parts.width[i])
+                    .member("height", parts.height[i])
+                    .member("grain_direction", request.grains.get(parts.grain[i]))
+                    .end_object();
+            }
+        }
+        json.end_array();
+
+        json.end_object();
+        written = json.flush();
+    }
+
+    if (std::fclose(file) != 0 || !written) {
+        error = "Failed to write request file: " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace AutoNestCut
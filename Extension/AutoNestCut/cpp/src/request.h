@@ -0,0 +1,89 @@
+#pragma once
+
+#include "json_reader.h"
+#include "nesting.h"
+#include "string_table.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Most distinct materials and grain directions a request may use; MaterialId
+// and GrainId are 16 bits
+constexpr size_t MAX_MATERIALS = 65536;
+constexpr size_t MAX_GRAINS = 65536;
+
+// Stock size for one material; defaults apply when the request has no board
+struct BoardSize {
+    double width = 2440.0;
+    double height = 1220.0;
+};
+
+// Fully parsed nesting job: settings, stock sizes and parts grouped by material.
+// Materials, grain directions and part IDs are interned at parse time; the
+// per-material vectors are indexed by MaterialId, and each material's parts
+// are stored column-wise in a PartStore.
+struct NestRequest {
+    Settings settings;
+    StringTable materials;
+    StringTable grains;
+    StringTable part_ids;
+    std::vector<BoardSize> board_sizes;
+    std::vector<PartStore> parts_by_material;
+    size_t part_count = 0;
+    
+    // Delta requests: edits against a saved session. Parts listed under
+    // "added" or "modified" are read into the pools like "parts".
+    std::string base_session;
+    std::vector<std::string> removed_part_ids;
+    
+    // Handle for a material name, growing the per-material vectors as needed.
+    // Handles wrap past MAX_MATERIALS, so readers reject such requests once
+    // done (too_many_materials()).
+    MaterialId material_id(std::string_view name) {
+        MaterialId id = static_cast<MaterialId>(materials.intern(name));
+        if (id >= parts_by_material.size()) {
+            parts_by_material.resize(id + 1);
+            board_sizes.resize(id + 1);
+        }
+        return id;
+    }
+    
+    // Handle for a grain direction; wraps past MAX_GRAINS like material_id()
+    GrainId grain_id(std::string_view grain) {
+        return static_cast<GrainId>(grains.intern(grain));
+    }
+    
+    bool too_many_materials() const { return materials.size() > MAX_MATERIALS; }
+    bool too_many_grains() const { return grains.size() > MAX_GRAINS; }
+
+    // Materials that have parts, ordered by name
+    std::vector<MaterialId> materials_by_name() const;
+    
+    // Area lower bound on the boards the job uses, summed over materials;
+    // for reserving the solution's board records once up front
+    size_t min_boards() const;
+};
+
+// Parse grain direction to allowed rotations
+RotationMask parse_grain_direction(std::string_view grain);
+
+// Fill in each part's allowed rotations from its grain direction. Runs after
+// parsing because settings may appear after the parts array.
+void assign_rotations(NestRequest& request);
+
+// Parse a JSON request in place. `data` is modified while parsing (escape
+// sequences are decoded in place) and parts are appended to their material
+// pool as tokens arrive, without an intermediate document tree.
+bool parse_request(char* data, size_t size, NestRequest& request, std::string& error);
+
+// Streaming variant: parses while `input` is still being read
+bool parse_request(JsonInput& input, NestRequest& request, std::string& error);
+
+// Write the request back as a JSON request. Every material gets a board
+// entry and parts are grouped by material, so parsing the file again gives
+// the same material handles and part indices.
+bool write_request(const std::string& path, const NestRequest& request, std::string& error);
+
+} // namespace AutoNestCut
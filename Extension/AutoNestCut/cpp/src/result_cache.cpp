@@ -0,0 +1,170 @@
+#include "result_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace AutoNestCut {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const CACHE_EXTENSION = ".ancc";
+
+// Position of each part in its material's canonical order
+std::vector<uint32_t> canonical_ranks(const PartStore& parts) {
+    std::vector<uint32_t> order = canonical_order(parts);
+    std::vector<uint32_t> rank(order.size());
+    for (uint32_t r = 0; r < order.size(); r++) rank[order[r]] = r;
+    return rank;
+}
+
+} // namespace
+
+std::vector<uint32_t> canonical_order(const PartStore& parts) {
+    std::vector<uint32_t> order(parts.size());
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&parts](uint32_t a, uint32_t b) {
+        if (parts.width[a] != parts.width[b]) return parts.width[a] < parts.width[b];
+        if (parts.height[a] != parts.height[b]) return parts.height[a] < parts.height[b];
+        if (parts.rotations[a] != parts.rotations[b]) return parts.rotations[a] < parts.rotations[b];
+        return a < b;
+    });
+    return order;
+}
+
+uint64_t job_hash(const NestRequest& request, const std::vector<MaterialId>& material_order) {
+    Fnv1a hash;
+    hash.add(NEST_ALGORITHM, std::strlen(NEST_ALGORITHM));
+    hash.add(request.settings.kerf_width);
+    hash.add(static_cast<uint8_t>(request.settings.allow_rotation));
+    hash.add(request.settings.min_offcut_size);
+
+    hash.add(static_cast<uint64_t>(material_order.size()));
+    for (MaterialId material : material_order) {
+        const BoardSize& board = request.board_sizes[material];
+        const PartStore& parts = request.parts_by_material[material];
+        hash.add(board.width);
+        hash.add(board.height);
+        hash.add(static_cast<uint64_t>(parts.size()));
+        for (uint32_t part : canonical_order(parts)) {
+            hash.add(parts.width[part]);
+            hash.add(parts.height[part]);
+            hash.add(parts.rotations[part]);
+        }
+    }
+    return hash.value();
+}
+
+std::string hash_to_hex(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+ResultCache::ResultCache(std::string directory, size_t capacity)
+    : directory_(std::move(directory)), capacity_(capacity) {}
+
+std::string ResultCache::entry_path(uint64_t hash) const {
+    return (fs::path(directory_) / (hash_to_hex(hash) + CACHE_EXTENSION)).string();
+}
+
+bool ResultCache::load(uint64_t hash, const NestRequest& request,
+                       const std::vector<MaterialId>& material_order, Solution& solution) {
+    std::string path = entry_path(hash);
+    Solution cached;
+    if (!load_solution(path, hash, cached)) return false;
+
+    // Map canonical positions back onto this request's parts
+    std::vector<std::vector<uint32_t>> orders;
+    orders.reserve(material_order.size());
+    for (MaterialId material : material_order) {
+        orders.push_back(canonical_order(request.parts_by_material[material]));
+    }
+
+    for (auto& placement : cached.placements) {
+        if (placement.material >= orders.size() || placement.part >= orders[placement.material].size()) {
+            return false;
+        }
+        placement.part = orders[placement.material][placement.part];
+        placement.material = material_order[placement.material];
+    }
+    for (auto& board : cached.boards) {
+        if (board.material >= material_order.size()) return false;
+        board.material = material_order[board.material];
+    }
+
+    solution = std::move(cached);
+
+    // Mark as recently used
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool ResultCache::store(uint64_t hash, const NestRequest& request,
+                        const std::vector<MaterialId>& material_order,
+                        const Solution& solution, std::string& error) {
+    // Canonical form: material index in nesting order, canonical part position
+    std::vector<uint16_t> ordinal(request.parts_by_material.size(), 0);
+    std::vector<std::vector<uint32_t>> ranks(request.parts_by_material.size());
+    for (size_t m = 0; m < material_order.size(); m++) {
+        ordinal[material_order[m]] = static_cast<uint16_t>(m);
+        ranks[material_order[m]] = canonical_ranks(request.parts_by_material[material_order[m]]);
+    }
+
+    Solution canonical;
+    canonical.placements = solution.placements;
+    canonical.boards = solution.boards;
+    canonical.offcuts = solution.offcuts;
+    for (auto& placement : canonical.placements) {
+        placement.part = ranks[placement.material][placement.part];
+        placement.material = ordinal[placement.material];
+    }
+    for (auto& board : canonical.boards) {
+        board.material = ordinal[board.material];
+    }
+
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+    if (ec) {
+        error = "Cannot create cache directory: " + directory_;
+        return false;
+    }
+
+    // Write to a temporary file and rename, so readers never see a partial entry
+    std::string path = entry_path(hash);
+    std::string temp_path = path + ".tmp";
+    bool written = save_solution(temp_path, hash, canonical, error);
+    if (written) fs::rename(temp_path, path, ec);
+    if (!written || ec) {
+        fs::remove(temp_path, ec);
+        error = "Failed to write cache file: " + path;
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+void ResultCache::evict() {
+    std::error_code ec;
+    std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+    for (fs::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != CACHE_EXTENSION) continue;
+        std::error_code time_ec;
+        auto time = it->last_write_time(time_ec);
+        if (!time_ec) entries.emplace_back(time, it->path());
+    }
+    if (entries.size() <= capacity_) return;
+
+    // Oldest first
+    std::sort(entries.begin(), entries.end());
+    for (size_t i = 0; i < entries.size() - capacity_; i++) {
+        fs::remove(entries[i].second, ec);
+    }
+}
+
+} // namespace AutoNestCut
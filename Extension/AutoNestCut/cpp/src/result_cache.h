@@ -0,0 +1,76 @@
+#pragma once
+
+#include "request.h"
+#include "solution.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Identifies the nesting engine in job hashes; bump it whenever a change to
+// the algorithm can change layouts, so stale cache entries stop matching.
+constexpr const char* NEST_ALGORITHM = "bottom-left-area-desc v1";
+
+// 64-bit FNV-1a over raw bytes
+class Fnv1a {
+public:
+    void add(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash_ ^= bytes[i];
+            hash_ *= 0x100000001B3ull;
+        }
+    }
+
+    template <typename T>
+    void add(const T& value) { add(&value, sizeof(value)); }
+
+    uint64_t value() const { return hash_; }
+
+private:
+    uint64_t hash_ = 0xCBF29CE484222325ull;
+};
+
+// Parts of one material in canonical order: by width, height and allowed
+// rotations. Parts that compare equal are interchangeable in a layout, so
+// position i of this order identifies "the i-th part of this shape" no matter
+// how the request listed the parts or what they are called.
+std::vector<uint32_t> canonical_order(const PartStore& parts);
+
+// Canonical hash of everything that determines the layout:
+// settings, the nesting algorithm and, per material in nesting order, the
+// board size and the multiset of part dimensions and rotation masks. Part
+// IDs, material names and grain labels are not included.
+uint64_t job_hash(const NestRequest& request, const std::vector<MaterialId>& material_order);
+
+std::string hash_to_hex(uint64_t hash);
+
+// On-disk LRU cache of nesting results, one file per job hash.
+//
+// Entries store the solution in canonical form: placements refer to parts by
+// canonical position and to materials by their index in the nesting order.
+// Loading maps them back onto the current request, so a request that only
+// renamed parts (or changed other non-geometric attributes) gets the cached
+// layout with its own part IDs. A hit refreshes the entry's timestamp;
+// storing evicts the oldest entries beyond `capacity`.
+class ResultCache {
+public:
+    ResultCache(std::string directory, size_t capacity = 64);
+
+    bool load(uint64_t hash, const NestRequest& request,
+              const std::vector<MaterialId>& material_order, Solution& solution);
+
+    bool store(uint64_t hash, const NestRequest& request,
+               const std::vector<MaterialId>& material_order,
+               const Solution& solution, std::string& error);
+
+private:
+    std::string directory_;
+    size_t capacity_;
+
+    std::string entry_path(uint64_t hash) const;
+    void evict();
+};
+
+} // namespace AutoNestCut
@@ -0,0 +1,292 @@
+#include "session.h"
+#include "input_source.h"
+#include "result_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <system_error>
+#include <unordered_set>
+
+namespace AutoNestCut {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t DROPPED = std::numeric_limits<uint32_t>::max();
+
+std::string session_path(const std::string& directory, const std::string& id, const char* extension) {
+    return (fs::path(directory) / (id + extension)).string();
+}
+
+bool parse_session_id(const std::string& id, uint64_t& key) {
+    if (id.empty() || id.size() > 16) return false;
+    char* end = nullptr;
+    key = std::strtoull(id.c_str(), &end, 16);
+    return *end == '\0';
+}
+
+// Copy one board with its placements and offcuts into `out` under a new ID.
+// `part_map` translates the board's part indices into `out`'s request.
+void append_board(Solution& out, const Solution& source, const BoardRecord& board,
+                  const std::vector<uint32_t>& part_map, int32_t id) {
+    BoardRecord record = board;
+    record.id = id;
+    record.first_placement = static_cast<uint32_t>(out.placements.size());
+    record.first_offcut = static_cast<uint32_t>(out.offcuts.size());
+
+    for (uint32_t i = 0; i < board.placement_count; i++) {
+        Placement placement = source.placements[board.first_placement + i];
+        placement.part = part_map[placement.part];
+        placement.board_id = id;
+        out.placements.push_back(placement);
+    }
+    out.offcuts.insert(out.offcuts.end(),
+                       source.offcuts.begin() + board.first_offcut,
+                       source.offcuts.begin() + board.first_offcut + board.offcut_count);
+    out.boards.push_back(record);
+}
+
+// Copy part `i` of `from` (a part of `from_request`) into `to_request`
+uint32_t copy_part(const NestRequest& from_request, const PartStore& from, uint32_t i,
+                   NestRequest& to_request, MaterialId material) {
+    Part part;
+    part.width = from.width[i];
+    part.height = from.height[i];
+    part.id = to_request.part_ids.add(from_request.part_ids.get(from.id[i]));
+    part.material = material;
+    part.grain = to_request.grain_id(from_request.grains.get(from.grain[i]));
+    part.type_index = static_cast<uint32_t>(to_request.part_count++);
+    part.instance = 0;
+    return to_request.parts_by_material[material].add(part);
+}
+
+} // namespace
+
+std::string session_id(const NestRequest& request, const std::vector<MaterialId>& material_order) {
+    Fnv1a hash;
+    hash.add(job_hash(request, material_order));
+    for (MaterialId material : material_order) {
+        std::string_view name = request.materials.get(material);
+        hash.add(name.data(), name.size());
+        hash.add('\0');
+
+        const PartStore& parts = request.parts_by_material[material];
+        for (uint32_t i = 0; i < parts.size(); i++) {
+            std::string_view id = request.part_ids.get(parts.id[i]);
+            hash.add(id.data(), id.size());
+            hash.add('\0');
+        }
+    }
+    return hash_to_hex(hash.value());
+}
+
+bool save_session(const std::string& directory, const std::string& id,
+                  const NestRequest& request, const Solution& solution, std::string& error) {
+    uint64_t key;
+    if (!parse_session_id(id, key)) {
+        error = "Invalid session ID: " + id;
+        return false;
+    }
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec) {
+        error = "Cannot create session directory: " + directory;
+        return false;
+    }
+
+    return write_request(session_path(directory, id, ".json"), request, error) &&
+           save_solution(session_path(directory, id, ".layout"), key, solution, error);
+}
+
+bool load_session(const std::string& directory, const std::string& id,
+                  NestRequest& request, Solution& solution, std::string& error) {
+    uint64_t key;
+    if (!parse_session_id(id, key)) {
+        error = "Invalid session ID: " + id;
+        return false;
+    }
+
+    MappedFile input;
+    if (!input.open(session_path(directory, id, ".json"), error)) {
+        error = "Unknown session " + id + ": " + error;
+        return false;
+    }
+    if (!parse_request(input.data(), input.size(), request, error)) {
+        error = "Session " + id + " is damaged: " + error;
+        return false;
+    }
+    if (!load_solution(session_path(directory, id, ".layout"), key, solution)) {
+        error = "Session " + id + " has no readable layout";
+        return false;
+    }
+
+    for (const auto& placement : solution.placements) {
+        if (placement.material >= request.parts_by_material.size() ||
+            placement.part >= request.parts_by_material[placement.material].size()) {
+            error = "Session " + id + " layout does not match its request";
+            return false;
+        }
+    }
+    for (const auto& board : solution.boards) {
+        if (board.material >= request.parts_by_material.size()) {
+            error = "Session " + id + " layout does not match its request";
+            return false;
+        }
+    }
+    return true;
+}
+
+void apply_delta(const NestRequest& base, const Solution& base_solution, const NestRequest& delta,
+                 Nester& nester, NestRequest& merged, Solution& result, DeltaStats& stats) {
+    std::unordered_set<std::string_view> replaced(delta.removed_part_ids.begin(), delta.removed_part_ids.end());
+    for (const auto& parts : delta.parts_by_material) {
+        for (uint32_t i = 0; i < parts.size(); i++) replaced.insert(delta.part_ids.get(parts.id[i]));
+    }
+
+    // Base materials keep their handles; new materials are added after them
+    merged.settings = base.settings;
+    for (size_t m = 0; m < base.parts_by_material.size(); m++) {
+        merged.material_id(base.materials.get(static_cast<StringId>(m)));
+        merged.board_sizes[m] = base.board_sizes[m];
+    }
+
+    // Surviving base parts, and where they went in the merged request
+    std::vector<std::vector<uint32_t>> base_to_merged(base.parts_by_material.size());
+    std::vector<bool> material_changed(base.parts_by_material.size(), false);
+    for (size_t m = 0; m < base.parts_by_material.size(); m++) {
+        const PartStore& parts = base.parts_by_material[m];
+        base_to_merged[m].assign(parts.size(), DROPPED);
+        for (uint32_t i = 0; i < parts.size(); i++) {
+            if (replaced.count(base.part_ids.get(parts.id[i]))) {
+                material_changed[m] = true;
+            } else {
+                base_to_merged[m][i] = copy_part(base, parts, i, merged, static_cast<MaterialId>(m));
+            }
+        }
+    }
+
+    // Added and modified parts
+    std::vector<std::vector<uint32_t>> fresh;
+    for (size_t dm = 0; dm < delta.parts_by_material.size(); dm++) {
+        const PartStore& parts = delta.parts_by_material[dm];
+        if (parts.empty()) continue;
+        size_t known_materials = merged.materials.size();
+        MaterialId material = merged.material_id(delta.materials.get(static_cast<StringId>(dm)));
+        if (material >= known_materials) merged.board_sizes[material] = delta.board_sizes[dm];
+        if (fresh.size() <= material) fresh.resize(material + 1);
+        for (uint32_t i = 0; i < parts.size(); i++) {
+            fresh[material].push_back(copy_part(delta, parts, i, merged, material));
+        }
+    }
+    fresh.resize(merged.parts_by_material.size());
+    material_changed.resize(merged.parts_by_material.size(), false);
+    base_to_merged.resize(merged.parts_by_material.size());
+    for (size_t m = 0; m < fresh.size(); m++) {
+        if (!fresh[m].empty()) material_changed[m] = true;
+    }
+    assign_rotations(merged);
+
+    // Base boards per material, in their original order
+    std::vector<std::vector<uint32_t>> base_boards(merged.parts_by_material.size());
+    for (uint32_t b = 0; b < base_solution.boards.size(); b++) {
+        base_boards[base_solution.boards[b].material].push_back(b);
+    }
+
+    for (MaterialId material : merged.materials_by_name()) {
+        const std::vector<uint32_t>& boards = base_boards[material];
+        const std::vector<uint32_t>& part_map = base_to_merged[material];
+        const PartStore& merged_parts = merged.parts_by_material[material];
+
+        // A board is re-nested if it lost a part; the last board also takes
+        // part in any change, since it is usually only partly filled
+        std::vector<bool> repack(boards.size(), false);
+        std::vector<bool> placed(base.parts_by_material.size() > material ?
+                                 base.parts_by_material[material].size() : 0, false);
+        for (size_t k = 0; k < boards.size(); k++) {
+            const BoardRecord& board = base_solution.boards[boards[k]];
+            for (uint32_t i = 0; i < board.placement_count; i++) {
+                uint32_t part = base_solution.placements[board.first_placement + i].part;
+                placed[part] = true;
+                if (part_map[part] == DROPPED) repack[k] = true;
+            }
+        }
+        if (material_changed[material] && !boards.empty()) repack.back() = true;
+
+        // Parts to nest: survivors of re-nested boards, parts that never got
+        // a place, and the new parts
+        std::vector<uint32_t> to_nest;
+        std::vector<int32_t> free_ids;
+        int32_t next_id = 1;
+        for (size_t k = 0; k < boards.size(); k++) {
+            const BoardRecord& board = base_solution.boards[boards[k]];
+            next_id = std::max(next_id, board.id + 1);
+            if (!repack[k]) continue;
+            free_ids.push_back(board.id);
+            for (uint32_t i = 0; i < board.placement_count; i++) {
+                uint32_t part = part_map[base_solution.placements[board.first_placement + i].part];
+                if (part != DROPPED) to_nest.push_back(part);
+            }
+        }
+        for (uint32_t part = 0; part < placed.size(); part++) {
+            if (!placed[part] && part_map[part] != DROPPED) to_nest.push_back(part_map[part]);
+        }
+        to_nest.insert(to_nest.end(), fresh[material].begin(), fresh[material].end());
+
+        Solution repacked;
+        std::vector<uint32_t> subset_map;
+        if (!to_nest.empty()) {
+            PartStore subset;
+            subset.reserve(to_nest.size());
+            for (uint32_t part : to_nest) {
+                Part p;
+                p.width = merged_parts.width[part];
+                p.height = merged_parts.height[part];
+                p.id = merged_parts.id[part];
+                p.material = material;
+                p.grain = merged_parts.grain[part];
+                p.type_index = merged_parts.type_index[part];
+                p.instance = merged_parts.instance[part];
+                uint32_t index = subset.add(p);
+                subset.rotations[index] = merged_parts.rotations[part];
+                subset_map.push_back(part);
+            }
+            const BoardSize& board_size = merged.board_sizes[material];
+            nester.nest_parts(subset, material, board_size.width, board_size.height, repacked);
+        }
+
+        // Kept boards and re-nested boards, ordered by board ID
+        struct Entry {
+            int32_t id;
+            const Solution* source;
+            const BoardRecord* board;
+            const std::vector<uint32_t>* map;
+        };
+        std::vector<Entry> entries;
+        for (size_t k = 0; k < boards.size(); k++) {
+            if (repack[k]) continue;
+            const BoardRecord& board = base_solution.boards[boards[k]];
+            entries.push_back({board.id, &base_solution, &board, &part_map});
+        }
+        std::sort(free_ids.begin(), free_ids.end());
+        for (size_t k = 0; k < repacked.boards.size(); k++) {
+            int32_t id = k < free_ids.size() ? free_ids[k] : next_id++;
+            entries.push_back({id, &repacked, &repacked.boards[k], &subset_map});
+        }
+        std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.id < b.id; });
+
+        for (const Entry& entry : entries) {
+            append_board(result, *entry.source, *entry.board, *entry.map, entry.id);
+        }
+
+        stats.boards_kept += entries.size() - repacked.boards.size();
+        stats.boards_repacked += repacked.boards.size();
+        stats.parts_repacked += to_nest.size();
+    }
+}
+
+} // namespace AutoNestCut
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "nesting.h"
+#include "request.h"
+#include "solution.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace AutoNestCut {
+
+// Saved nesting sessions, the base for delta requests.
+//
+// A session is stored as two files in the session directory: "<id>.json",
+// the full request written back as a regular JSON request (so it is re-read
+// with parse_request and gets the same material and part indices), and
+// "<id>.layout", the solution's records as written by save_solution.
+//
+// The session ID is a hash of the job (see job_hash) together with the
+// material names and part IDs, since delta requests refer to parts by ID.
+std::string session_id(const NestRequest& request, const std::vector<MaterialId>& material_order);
+
+bool save_session(const std::string& directory, const std::string& id,
+                  const NestRequest& request, const Solution& solution, std::string& error);
+
+bool load_session(const std::string& directory, const std::string& id,
+                  NestRequest& request, Solution& solution, std::string& error);
+
+struct DeltaStats {
+    size_t boards_kept = 0;
+    size_t boards_repacked = 0;
+    size_t parts_repacked = 0;
+};
+
+// Apply a delta request to a saved session and repair its layout.
+//
+// `merged` receives the base request with the delta applied: parts whose ID
+// is listed in `removed` are dropped, and each part in the delta replaces the
+// base parts with the same ID (modified) or is new (added). Settings and the
+// board sizes of existing materials come from the base session.
+//
+// Per material, only the boards that lost a part, plus the last board when
+// the material changed at all, are re-nested together with the new parts.
+// Every other board keeps its ID and placements, so sheets already cut stay
+// valid. Re-nested boards reuse the freed board IDs first.
+void apply_delta(const NestRequest& base, const Solution& base_solution, const NestRequest& delta,
+                 Nester& nester, NestRequest& merged, Solution& result, DeltaStats& stats);
+
+} // namespace AutoNestCut
@@ -0,0 +1,115 @@
+#include "solution.h"
+#include <cstdio>
+#include <cstring>
+
+namespace AutoNestCut {
+
+namespace {
+
+const char SOLUTION_MAGIC[4] = {'A', 'N', 'C', 'S'};
+constexpr uint16_t SOLUTION_VERSION = 1;
+
+struct SolutionHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint64_t key;
+    uint32_t board_count;
+    uint32_t placement_count;
+    uint32_t offcut_count;
+    uint32_t record_sizes; // sizeof(BoardRecord) | sizeof(Placement) << 8 | sizeof(Rect) << 16
+};
+
+static_assert(sizeof(SolutionHeader) == 32, "solution header layout");
+
+uint32_t record_sizes() {
+    return static_cast<uint32_t>(sizeof(BoardRecord) | sizeof(Placement) << 8 | sizeof(Rect) << 16);
+}
+
+template <typename T>
+bool read_records(std::FILE* file, std::vector<T>& out, size_t count) {
+    out.resize(count);
+    return count == 0 || std::fread(out.data(), sizeof(T), count, file) == count;
+}
+
+template <typename T>
+bool write_records(std::FILE* file, const std::vector<T>& records) {
+    return records.empty() || std::fwrite(records.data(), sizeof(T), records.size(), file) == records.size();
+}
+
+} // namespace
+
+void Solution::append(const Solution& other) {
+    uint32_t placement_offset = static_cast<uint32_t>(placements.size());
+    uint32_t offcut_offset = static_cast<uint32_t>(offcuts.size());
+    placements.insert(placements.end(), other.placements.begin(), other.placements.end());
+    offcuts.insert(offcuts.end(), other.offcuts.begin(), other.offcuts.end());
+    
+    boards.reserve(boards.size() + other.boards.size());
+    for (BoardRecord board : other.boards) {
+        board.first_placement += placement_offset;
+        board.first_offcut += offcut_offset;
+        boards.push_back(board);
+    }
+}
+
+
+bool save_solution(const std::string& path, uint64_t key, const Solution& solution, std::string& error) {
+    SolutionHeader header{};
+    std::memcpy(header.magic, SOLUTION_MAGIC, 4);
+    header.version = SOLUTION_VERSION;
+    header.key = key;
+    header.board_count = static_cast<uint32_t>(solution.boards.size());
+    header.placement_count = static_cast<uint32_t>(solution.placements.size());
+    header.offcut_count = static_cast<uint32_t>(solution.offcuts.size());
+    header.record_sizes = record_sizes();
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "Cannot open file: " + path;
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   write_records(file, solution.boards) &&
+                   write_records(file, solution.placements) &&
+                   write_records(file, solution.offcuts);
+    if (std::fclose(file) != 0) written = false;
+    if (!written) {
+        error = "Failed to write file: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool load_solution(const std::string& path, uint64_t key, Solution& solution) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    SolutionHeader header;
+    Solution loaded;
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+              std::memcmp(header.magic, SOLUTION_MAGIC, 4) == 0 &&
+              header.version == SOLUTION_VERSION &&
+              header.key == key &&
+              header.record_sizes == record_sizes() &&
+              read_records(file, loaded.boards, header.board_count) &&
+              read_records(file, loaded.placements, header.placement_count) &&
+              read_records(file, loaded.offcuts, header.offcut_count);
+    std::fclose(file);
+    if (!ok) return false;
+
+    // Ranges must stay inside the arrays
+    for (const auto& board : loaded.boards) {
+        if (board.first_placement > loaded.placements.size() ||
+            board.placement_count > loaded.placements.size() - board.first_placement ||
+            board.first_offcut > loaded.offcuts.size() ||
+            board.offcut_count > loaded.offcuts.size() - board.first_offcut) {
+            return false;
+        }
+    }
+
+    solution = std::move(loaded);
+    return true;
+}
+
+} // namespace AutoNestCut
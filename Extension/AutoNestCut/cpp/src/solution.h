@@ -0,0 +1,72 @@
+#pragma once
+
+#include "geometry.h"
+#include "part_store.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace AutoNestCut {
+
+// One placed part. Parts are referred to by index into their material's
+// PartStore, which nesting never modifies, so a placement is plain data.
+struct Placement {
+    double x;
+    double y;
+    uint32_t part;
+    int32_t board_id;
+    int32_t rotation;     // 0, 90, 180 or 270
+    MaterialId material;
+};
+
+// A finished board. Its placements are the contiguous range
+// [first_placement, first_placement + placement_count) of the solution, and
+// likewise its offcuts.
+struct BoardRecord {
+    double width;
+    double height;
+    double placed_area;
+    int32_t id;
+    MaterialId material;
+    uint32_t first_placement;
+    uint32_t placement_count;
+    uint32_t first_offcut;
+    uint32_t offcut_count;
+    
+    double used_area() const { return placed_area; }
+    double waste_percentage() const {
+        double total = width * height;
+        if (total == 0) return 0;
+        return ((total - used_area()) / total) * 100.0;
+    }
+};
+
+static_assert(std::is_trivially_copyable<Placement>::value, "Placement must be trivially copyable");
+static_assert(std::is_trivially_copyable<BoardRecord>::value, "BoardRecord must be trivially copyable");
+
+// Result of a nesting run: flat arrays of trivially copyable records, so
+// candidate solutions can be compared or merged with plain memcpy. Solutions
+// are move-only; results are appended in place rather than copied around.
+struct Solution {
+    std::vector<Placement> placements; // Grouped by board, in placement order
+    std::vector<BoardRecord> boards;
+    std::vector<Rect> offcuts;         // Usable leftover pieces, grouped by board
+    
+    Solution() = default;
+    Solution(Solution&&) = default;
+    Solution& operator=(Solution&&) = default;
+    Solution(const Solution&) = delete;
+    Solution& operator=(const Solution&) = delete;
+    
+    // Append another solution's boards, placements and offcuts
+    void append(const Solution& other);
+};
+
+// Save/load a solution's records to a file in host layout, tagged with a
+// caller-chosen key. Only meant to be read back by the same build (caches,
+// sessions); load fails on any mismatch.
+bool save_solution(const std::string& path, uint64_t key, const Solution& solution, std::string& error);
+bool load_solution(const std::string& path, uint64_t key, Solution& solution);
+
+} // namespace AutoNestCut
@@ -0,0 +1,25 @@
+#include "string_table.h"
+#include <functional>
+
+namespace AutoNestCut {
+
+StringId StringTable::intern(std::string_view str) {
+    // Keyed by hash so lookups never allocate; the arena holds the only copy
+    size_t hash = std::hash<std::string_view>()(str);
+    auto range = index_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (get(it->second) == str) return it->second;
+    }
+    StringId id = add(str);
+    index_.emplace(hash, id);
+    return id;
+}
+
+StringId StringTable::add(std::string_view str) {
+    StringId id = static_cast<StringId>(spans_.size());
+    spans_.push_back({static_cast<uint32_t>(arena_.size()), static_cast<uint32_t>(str.size())});
+    arena_.insert(arena_.end(), str.begin(), str.end());
+    return id;
+}
+
+} // namespace AutoNestCut
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace AutoNestCut {
+
+using StringId = uint32_t;
+
+// Append-only string arena. Strings are stored back to back in one buffer and
+// referred to by dense integer handles, so the engine can work on handles and
+// only resolve text when writing output. Views returned by get() are valid
+// until the next add()/intern().
+class StringTable {
+public:
+    // Return the handle of an equal string, adding it if not present yet.
+    // Meant for low-cardinality strings (materials, grain directions).
+    StringId intern(std::string_view str);
+
+    // Always append, without deduplication (part IDs)
+    StringId add(std::string_view str);
+
+    std::string_view get(StringId id) const {
+        const Span& span = spans_[id];
+        return std::string_view(arena_.data() + span.offset, span.length);
+    }
+
+    size_t size() const { return spans_.size(); }
+    size_t bytes() const { return arena_.size(); }
+
+private:
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    std::vector<char> arena_;
+    std::vector<Span> spans_;
+    std::unordered_multimap<size_t, StringId> index_; // hash -> handle
+};
+
+} // namespace AutoNestCut
@@ -0,0 +1,88 @@
+#include "trace.h"
+
+namespace AutoNestCut {
+
+Trace::~Trace() {
+    close();
+}
+
+bool Trace::open(const std::string& path, std::string& error) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        error = "Cannot open trace file: " + path;
+        return false;
+    }
+    start_ = std::chrono::steady_clock::now();
+    json_ = std::make_unique<JsonWriter>(file_);
+    json_->begin_object()
+        .member("displayTimeUnit", "ms");
+    json_->key("traceEvents").begin_array();
+    return true;
+}
+
+bool Trace::close() {
+    if (!file_) return true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    json_->end_array();
+    json_->end_object();
+    bool written = json_->flush();
+    json_.reset();
+    if (std::fclose(file_) != 0) written = false;
+    file_ = nullptr;
+    return written;
+}
+
+uint32_t Trace::thread_id() {
+    auto found = thread_ids_.find(std::this_thread::get_id());
+    if (found != thread_ids_.end()) return found->second;
+    uint32_t id = static_cast<uint32_t>(thread_ids_.size() + 1);
+    thread_ids_.emplace(std::this_thread::get_id(), id);
+    return id;
+}
+
+void Trace::begin_event(std::string_view name, const char* phase, double ts_us) {
+    json_->begin_object()
+        .member("name", name)
+        .member("ph", phase)
+        .member("ts", ts_us)
+        .member("pid", 1)
+        .member("tid", thread_id());
+}
+
+void Trace::name_thread(std::string_view name) {
+    if (!file_) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    begin_event("thread_name", "M", 0);
+    json_->key("args").begin_object()
+        .member("name", name)
+        .end_object();
+    json_->end_object();
+}
+
+void Trace::span(std::string_view name, std::string_view category, double start_us, double end_us,
+                 const TraceArg* args, size_t arg_count) {
+    if (!file_) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    begin_event(name, "X", start_us);
+    json_->member("dur", end_us - start_us)
+        .member("cat", category);
+    if (arg_count > 0) {
+        json_->key("args").begin_object();
+        for (size_t i = 0; i < arg_count; i++) json_->member(args[i].key, args[i].value);
+        json_->end_object();
+    }
+    json_->end_object();
+}
+
+void Trace::counter(std::string_view name, double value) {
+    if (!file_) return;
+    double ts = now_us();
+    std::lock_guard<std::mutex> lock(mutex_);
+    begin_event(name, "C", ts);
+    json_->key("args").begin_object()
+        .member(name, value)
+        .end_object();
+    json_->end_object();
+}
+
+} // namespace AutoNestCut
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "json_writer.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace AutoNestCut {
+
+struct TraceArg {
+    const char* key;
+    double value;
+};
+
+// Timeline in the Chrome trace-event JSON format, streamed to a file as
+// events arrive; load it in about:tracing or ui.perfetto.dev. Spans are
+// complete ("X") events on the thread that recorded them, counters are
+// "C" events. Safe to use from several threads.
+class Trace {
+public:
+    Trace() = default;
+    ~Trace();
+
+    Trace(const Trace&) = delete;
+    Trace& operator=(const Trace&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+
+    // Finish the document; returns false if any write failed
+    bool close();
+
+    // Microseconds since open()
+    double now_us() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    // Name the calling thread in the viewer
+    void name_thread(std::string_view name);
+
+    void span(std::string_view name, std::string_view category, double start_us, double end_us,
+              const TraceArg* args = nullptr, size_t arg_count = 0);
+
+    // One sample of the counter track `name`
+    void counter(std::string_view name, double value);
+
+private:
+    std::FILE* file_ = nullptr;
+    std::unique_ptr<JsonWriter> json_;
+    std::chrono::steady_clock::time_point start_;
+    std::mutex mutex_;
+    std::unordered_map<std::thread::id, uint32_t> thread_ids_;
+
+    // Small ID for the calling thread; caller holds mutex_
+    uint32_t thread_id();
+    void begin_event(std::string_view name, const char* phase, double ts_us);
+};
+
+// Records a span from construction to destruction; does nothing when the
+// trace is null. Up to four numeric args can be attached before it ends.
+// Use NEST_TRACE_SPAN so the span compiles out with the profiling probes.
+class TraceSpan {
+public:
+    TraceSpan(Trace* trace, std::string_view name, const char* category)
+        : trace_(trace), name_(trace ? name : std::string_view()), category_(category),
+          start_us_(trace ? trace->now_us() : 0) {}
+
+    ~TraceSpan() {
+        if (trace_) trace_->span(name_, category_, start_us_, trace_->now_us(), args_, arg_count_);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void arg(const char* key, double value) {
+        if (arg_count_ < 4) args_[arg_count_++] = {key, value};
+    }
+
+private:
+    Trace* trace_;
+    std::string name_;
+    const char* category_;
+    double start_us_;
+    TraceArg args_[4];
+    size_t arg_count_ = 0;
+};
+
+} // namespace AutoNestCut
@@ -0,0 +1,429 @@
+// Regression check: nests the jobs listed in a corpus manifest and fails on
+// invalid layouts, on yield regressions (more sheets than the golden count)
+// and on performance regressions (nesting slower than the case's budget).
+//
+// Usage: nester_regression --corpus FILE [--case NAME] [--repeat R] [--update]
+//
+// Each manifest line is "<name> <source> <sheets> <budget_ms>"; '#' starts a
+// comment. Sources, with paths relative to the manifest:
+//   file:PATH                          JSON or binary request
+//   workload:KIND:PARTS:MATERIALS:SEED generated job (see bench/workload.h)
+//   2bp:PATH:INSTANCE, cut:PATH        published-format instances
+//   grains:COUNT                       COUNT parts, each with its own grain
+//                                      direction; the first is "fixed"
+// A sheets value of "reject" means the request must fail to load.
+//
+// Budgets are for the nesting alone, fastest of R runs (default 5), in the
+// optimized build; AUTONESTCUT_TIME_SCALE multiplies them for slow machines
+// or instrumented builds. --update lowers the manifest's sheet counts to the
+// current results after a yield improvement; raising one is a manual edit.
+
+#include "binary_format.h"
+#include "input_source.h"
+#include "instances.h"
+#include "nesting.h"
+#include "request.h"
+#include "workload.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace AutoNestCut;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Case {
+    std::string name;
+    std::string source;
+    size_t sheets = 0;    // Golden sheet count
+    bool reject = false;  // Loading must fail
+    double budget_ms = 0;
+    size_t line = 0;      // In the manifest, for --update
+};
+
+void print_usage() {
+    std::fprintf(stderr,
+        "Usage: nester_regression --corpus FILE [--case NAME] [--repeat R] [--update]\n");
+}
+
+bool load_manifest(const std::string& path, std::vector<std::string>& lines,
+                   std::vector<Case>& cases, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "Cannot open corpus manifest: " + path;
+        return false;
+    }
+    std::string text;
+    while (std::getline(file, text)) {
+        lines.push_back(text);
+        std::string content = text.substr(0, text.find('#'));
+        std::istringstream fields(content);
+        Case entry;
+        if (!(fields >> entry.name)) continue;
+        std::string sheets;
+        if (!(fields >> entry.source >> sheets >> entry.budget_ms) ||
+            !(sheets == "reject" || std::istringstream(sheets) >> entry.sheets)) {
+            error = path + ":" + std::to_string(lines.size()) + ": expected <name> <source> <sheets> <budget_ms>";
+            return false;
+        }
+        entry.reject = sheets == "reject";
+        entry.line = lines.size() - 1;
+        cases.push_back(entry);
+    }
+    return true;
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for (;;) {
+        size_t end = text.find(separator, start);
+        parts.push_back(text.substr(start, end - start));
+        if (end == std::string::npos) return parts;
+        start = end + 1;
+    }
+}
+
+bool load_file_request(const std::string& path, NestRequest& request, std::string& error) {
+    MappedFile input;
+    if (!input.open(path, error)) return false;
+    if (input.size() >= 4 && std::memcmp(input.data(), "ANCQ", 4) == 0) {
+        return read_binary_request(input.data(), input.size(), request, error);
+    }
+    return parse_request(input.data(), input.size(), request, error);
+}
+
+// Generated jobs go through the JSON writer and parser, like the files the
+// benchmarks feed the nester
+bool load_workload(const std::vector<std::string>& fields, NestRequest& request, std::string& error) {
+    WorkloadSpec spec;
+    if (fields.size() != 5 || !parse_workload_kind(fields[1], spec.kind)) {
+        error = "expected workload:KIND:PARTS:MATERIALS:SEED";
+        return false;
+    }
+    spec.parts = std::strtoul(fields[2].c_str(), nullptr, 10);
+    spec.materials = std::strtoul(fields[3].c_str(), nullptr, 10);
+    spec.seed = std::strtoull(fields[4].c_str(), nullptr, 10);
+
+    std::FILE* file = std::tmpfile();
+    if (!file || !write_workload(file, generate_workload(spec))) {
+        if (file) std::fclose(file);
+        error = "cannot write generated workload";
+        return false;
+    }
+    std::vector<char> json(static_cast<size_t>(std::ftell(file)));
+    std::rewind(file);
+    size_t read = std::fread(json.data(), 1, json.size(), file);
+    std::fclose(file);
+    if (read != json.size()) {
+        error = "cannot read generated workload back";
+        return false;
+    }
+    return parse_request(json.data(), json.size(), request, error);
+}
+
+// Grain handles are 16 bits; past 65536 distinct directions they would wrap
+// onto other directions and e.g. let the "fixed" part rotate
+bool load_grains(const std::vector<std::string>& fields, NestRequest& request, std::string& error) {
+    if (fields.size() != 2) {
+        error = "expected grains:COUNT";
+        return false;
+    }
+    size_t count = std::strtoul(fields[1].c_str(), nullptr, 10);
+    std::string json = "{\"settings\": {\"kerf\": 3, \"allow_rotation\": true}, \"parts\": [";
+    for (size_t i = 0; i < count; i++) {
+        std::string grain = i == 0 ? "fixed" : "g" + std::to_string(i);
+        json += (i > 0 ? ", " : "") + std::string("{\"id\": \"p") + std::to_string(i) +
+                "\", \"material\": \"Board\", \"width\": 100, \"height\": 200, \"grain_direction\": \"" +
+                grain + "\"}";
+    }
+    json += "]}";
+    return parse_request(json.data(), json.size(), request, error);
+}
+
+bool load_case(const Case& entry, const fs::path& base, NestRequest& request, std::string& error) {
+    std::vector<std::string> fields = split(entry.source, ':');
+    const std::string& kind = fields[0];
+    if (kind == "file" && fields.size() == 2) {
+        return load_file_request((base / fields[1]).string(), request, error);
+    }
+    if (kind == "workload") {
+        return load_workload(fields, request, error);
+    }
+    if (kind == "grains") {
+        return load_grains(fields, request, error);
+    }
+    InstanceFormat format;
+    if (parse_instance_format(kind, format) && (fields.size() == 2 || fields.size() == 3)) {
+        std::vector<BenchmarkInstance> instances;
+        if (!load_instances((base / fields[1]).string(), format, instances, error)) return false;
+        for (auto& instance : instances) {
+            if (fields.size() == 2 || instance.name == fields[2]) {
+                request = std::move(instance.request);
+                return true;
+            }
+        }
+        error = "no instance " + fields.back() + " in " + fields[1];
+        return false;
+    }
+    error = "unknown source " + entry.source;
+    return false;
+}
+
+// Nest every material the way nester does; returns the wall time in ms
+double nest(const NestRequest& request, Solution& solution) {
+    auto start = std::chrono::steady_clock::now();
+    Nester nester(request.settings, &request.materials, &request.part_ids);
+    solution.placements.reserve(request.part_count);
+    for (MaterialId material : request.materials_by_name()) {
+        const BoardSize& board_size = request.board_sizes[material];
+        nester.nest_parts(request.parts_by_material[material], material,
+                          board_size.width, board_size.height, solution);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool rotation_allowed(RotationMask mask, int rotation) {
+    switch (rotation) {
+        case 0: return (mask & (ROTATE_0 | ROTATE_0_MIRRORED)) != 0;
+        case 90: return (mask & (ROTATE_90 | ROTATE_90_MIRRORED)) != 0;
+        case 180: return (mask & (ROTATE_180 | ROTATE_180_MIRRORED)) != 0;
+        case 270: return (mask & (ROTATE_270 | ROTATE_270_MIRRORED)) != 0;
+    }
+    return false;
+}
+
+// Whether the part fits an empty board in some allowed orientation; parts
+// that do not are reported by the solver and left out
+bool fits_board(const PartStore& parts, uint32_t part, const BoardSize& board, double kerf) {
+    auto fits = [&](double w, double h) {
+        bool whole_board = std::abs(w - board.width) < 0.1 && std::abs(h - board.height) < 0.1;
+        return whole_board || (w + kerf <= board.width && h + kerf <= board.height);
+    };
+    const RotationMask mask = parts.rotations[part];
+    return ((mask & ROTATE_UPRIGHT) && fits(parts.width[part], parts.height[part])) ||
+           ((mask & ROTATE_TURNED) && fits(parts.height[part], parts.width[part]));
+}
+
+// Layout checks; appends a message per problem found (up to 10 in all)
+void check_layout(const NestRequest& request, const Solution& solution, std::vector<std::string>& problems) {
+    const double eps = 1e-6;
+    const double kerf = request.settings.kerf_width;
+    auto report = [&problems](const std::string& message) {
+        if (problems.size() < 10) problems.push_back(message);
+    };
+
+    std::vector<std::vector<bool>> placed(request.parts_by_material.size());
+    for (size_t m = 0; m < placed.size(); m++) {
+        placed[m].assign(request.parts_by_material[m].size(), false);
+    }
+
+    struct Footprint { double x, y, w, h; };
+    std::vector<Footprint> footprints;
+    size_t covered = 0;
+
+    for (const BoardRecord& board : solution.boards) {
+        const std::string board_name = std::string(request.materials.get(board.material)) +
+                                       " board " + std::to_string(board.id);
+        if (board.first_placement + board.placement_count > solution.placements.size()) {
+            report(board_name + ": placement range out of bounds");
+            continue;
+        }
+        covered += board.placement_count;
+        const PartStore& parts = request.parts_by_material[board.material];
+        footprints.clear();
+
+        for (uint32_t i = board.first_placement; i < board.first_placement + board.placement_count; i++) {
+            const Placement& placement = solution.placements[i];
+            std::string part = placement.part < parts.size() ?
+                std::string(request.part_ids.get(parts.id[placement.part])) : "#" + std::to_string(placement.part);
+            if (placement.material != board.material || placement.board_id != board.id ||
+                placement.part >= parts.size()) {
+                report(board_name + ": placement of " + part + " does not belong to it");
+                continue;
+            }
+            if (placed[board.material][placement.part]) report(part + " placed twice");
+            placed[board.material][placement.part] = true;
+            if (!rotation_allowed(parts.rotations[placement.part], placement.rotation)) {
+                report(part + " placed at a forbidden rotation " + std::to_string(placement.rotation));
+            }
+
+            double w, h;
+            parts.get_rotated_dimensions(placement.part, placement.rotation, w, h);
+            // Parts keep a kerf to the right and top edges, except a part
+            // that fills the whole board
+            bool whole_board = std::abs(w - board.width) < 0.1 && std::abs(h - board.height) < 0.1;
+            double margin = whole_board ? 0 : kerf;
+            if (placement.x < -eps || placement.y < -eps ||
+                placement.x + w + margin > board.width + eps || placement.y + h + margin > board.height + eps) {
+                report(part + " exceeds " + board_name);
+            }
+            footprints.push_back({placement.x, placement.y, w, h});
+        }
+
+        // Parts must be at least a kerf apart
+        std::sort(footprints.begin(), footprints.end(),
+                  [](const Footprint& a, const Footprint& b) { return a.x < b.x; });
+        for (size_t i = 0; i < footprints.size(); i++) {
+            const Footprint& a = footprints[i];
+            for (size_t j = i + 1; j < footprints.size(); j++) {
+                const Footprint& b = footprints[j];
+                if (b.x >= a.x + a.w + kerf - eps) break;
+                if (b.y < a.y + a.h + kerf - eps && a.y < b.y + b.h + kerf - eps) {
+                    report(board_name + ": parts at (" + std::to_string(a.x) + ", " + std::to_string(a.y) +
+                           ") and (" + std::to_string(b.x) + ", " + std::to_string(b.y) + ") overlap");
+                }
+            }
+        }
+    }
+
+    if (covered != solution.placements.size()) report("placements outside every board");
+    for (size_t m = 0; m < placed.size(); m++) {
+        const PartStore& parts = request.parts_by_material[m];
+        const BoardSize& board = request.board_sizes[m];
+        size_t missing = 0;
+        for (uint32_t part = 0; part < parts.size(); part++) {
+            if (!placed[m][part] && fits_board(parts, part, board, kerf)) missing++;
+        }
+        if (missing > 0) {
+            report(std::to_string(missing) + " parts of " + std::string(request.materials.get(static_cast<MaterialId>(m))) +
+                   " that fit its board not placed");
+        }
+    }
+}
+
+bool write_manifest(const std::string& path, const std::vector<std::string>& lines) {
+    std::ofstream file(path, std::ios::trunc);
+    for (const auto& line : lines) file << line << '\n';
+    return static_cast<bool>(file);
+}
+
+// Replace the sheets column of a manifest line, keeping its layout
+void update_sheets(std::string& line, size_t sheets) {
+    size_t pos = 0;
+    for (int field = 0; field < 3; field++) {
+        pos = line.find_first_not_of(" \t", pos);
+        if (field < 2) pos = line.find_first_of(" \t", pos);
+    }
+    size_t end = line.find_first_of(" \t", pos);
+    std::string value = std::to_string(sheets);
+    std::string old = line.substr(pos, end - pos);
+    if (value.size() < old.size()) value.append(old.size() - value.size(), ' ');
+    line.replace(pos, end - pos, value);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string corpus;
+    std::string only;
+    int repeat = 5;
+    bool update = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+            corpus = argv[++i];
+        } else if (std::strcmp(argv[i], "--case") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (corpus.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    double time_scale = 1.0;
+    if (const char* scale = std::getenv("AUTONESTCUT_TIME_SCALE")) {
+        time_scale = std::max(0.0, std::atof(scale));
+    }
+
+    std::vector<std::string> lines;
+    std::vector<Case> cases;
+    std::string error;
+    if (!load_manifest(corpus, lines, cases, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return 1;
+    }
+    fs::path base = fs::path(corpus).parent_path();
+
+    int failures = 0;
+    int ran = 0;
+    for (const Case& entry : cases) {
+        if (!only.empty() && entry.name != only) continue;
+        ran++;
+
+        NestRequest request;
+        if (entry.reject) {
+            bool loaded = load_case(entry, base, request, error);
+            std::printf("%s %s: %s\n", loaded ? "FAIL" : "PASS", entry.name.c_str(),
+                        loaded ? "loaded, but must be rejected" : ("rejected: " + error).c_str());
+            if (loaded) failures++;
+            continue;
+        }
+        if (!load_case(entry, base, request, error)) {
+            std::printf("FAIL %s: %s\n", entry.name.c_str(), error.c_str());
+            failures++;
+            continue;
+        }
+
+        // The solver reports progress on stdout
+        Solution solution;
+        double best_ms = 0;
+        std::cout.setstate(std::ios::failbit);
+        for (int run = 0; run < repeat; run++) {
+            Solution attempt;
+            double ms = nest(request, attempt);
+            if (run == 0 || ms < best_ms) best_ms = ms;
+            if (run == 0) solution = std::move(attempt);
+        }
+        std::cout.clear();
+
+        std::vector<std::string> problems;
+        check_layout(request, solution, problems);
+        size_t sheets = solution.boards.size();
+        if (sheets > entry.sheets) {
+            problems.push_back("uses " + std::to_string(sheets) + " sheets, golden is " + std::to_string(entry.sheets));
+        }
+        double budget = entry.budget_ms * time_scale;
+        if (best_ms > budget) {
+            problems.push_back("took " + std::to_string(best_ms) + " ms, budget is " + std::to_string(budget) + " ms");
+        }
+
+        std::printf("%s %s: %zu parts, %zu/%zu sheets, %.2f ms (budget %.0f ms)\n",
+                    problems.empty() ? "PASS" : "FAIL", entry.name.c_str(), request.part_count,
+                    sheets, entry.sheets, best_ms, budget);
+        for (const auto& problem : problems) std::printf("  %s\n", problem.c_str());
+        if (sheets < entry.sheets && !update) {
+            std::printf("  fewer sheets than the golden count; run with --update to lower it\n");
+        }
+        if (!problems.empty()) failures++;
+        if (update && sheets < entry.sheets) update_sheets(lines[entry.line], sheets);
+    }
+
+    if (ran == 0) {
+        std::fprintf(stderr, "ERROR: no case %s in %s\n", only.c_str(), corpus.c_str());
+        return 1;
+    }
+    if (update && !write_manifest(corpus, lines)) {
+        std::fprintf(stderr, "ERROR: Cannot write %s\n", corpus.c_str());
+        return 1;
+    }
+    return failures > 0 ? 1 : 0;
+}